@@ -3,6 +3,9 @@
 #include <ctime>
 
 #include "url.h"
+#include "base.h"
+#include "batch.h"
+#include "deparam.h"
 
 /**
  * Run func() `count` times in each of `runs` experiments, where `name` provides a
@@ -50,10 +53,61 @@ int main(int argc, char* argv[]) {
         Url::Url parsed(full);
     });
 
+    Url::Url reused;
+    bench("reset", count, runs, [full, &reused]() {
+        reused.reset(full);
+    });
+
+    bench("view", count, runs, [full]() {
+        Url::UrlView view(full);
+    });
+
+    std::vector<Url::StringView> batch_urls(1000, Url::StringView(full));
+    Url::UrlBatch batch;
+    bench("batch of 1000", count / 1000, runs, [&batch_urls, &batch]() {
+        Url::parseBatch(batch_urls.data(), batch_urls.size(), batch);
+    });
+
     bench("relative", count, runs, [base_url, relative]() {
         Url::Url(relative).relative_to(base_url);
     });
 
+    bench("relative + str", count, runs, [base_url, relative]() {
+        Url::Url(relative).relative_to(base_url).str();
+    });
+
+    Url::BaseUrl prepared(base_url);
+    std::string resolved;
+    bench("BaseUrl::resolve", count, runs, [&prepared, relative, &resolved]() {
+        resolved.clear();
+        prepared.resolve(relative, resolved);
+    });
+
+    std::vector<Url::StringView> document(5000, Url::StringView(relative));
+    bench("chain over a document of 5000", count / 5000, runs, [&document, base_url]() {
+        for (auto it = document.begin(); it != document.end(); ++it)
+        {
+            Url::Url(it->str()).relative_to(base_url).defrag().abspath().escape().str();
+        }
+    });
+
+    Url::ResolvedLinks links;
+    bench("resolveAll over a document of 5000", count / 5000, runs,
+        [&document, &prepared, &links]() {
+            Url::resolveAll(prepared, document.data(), document.size(), links);
+        });
+
+    Url::Url parsed_full(full);
+    bench("str", count, runs, [&parsed_full]() {
+        parsed_full.str();
+    });
+
+    std::string buffer;
+    bench("str into buffer", count, runs, [&parsed_full, &buffer]() {
+        buffer.clear();
+        parsed_full.str(buffer);
+    });
+
     bench("parse + escape", count, runs, [full]() {
         Url::Url(full).escape();
     });
@@ -62,7 +116,35 @@ int main(int argc, char* argv[]) {
         Url::Url(full).abspath();
     });
 
+    bench("parse + sort_query", count, runs, [full]() {
+        Url::Url(full).sort_query();
+    });
+
     bench("parse + punycode", count, runs, [full]() {
         Url::Url(full).punycode();
     });
+
+    std::unordered_set<std::string> blacklist;
+    for (size_t index = 0; index < 400; ++index)
+    {
+        blacklist.insert("utm_param_" + std::to_string(index));
+    }
+    bench("parse + deparam", count, runs, [full, &blacklist]() {
+        Url::Url(full).deparam(blacklist);
+    });
+
+    Url::DeparamFilter filter(blacklist);
+    bench("parse + deparam with filter", count, runs, [full, &filter]() {
+        Url::Url(full).deparam(filter);
+    });
+
+    bench("parse + strip + deparam + sort_query", count, runs, [full, &filter]() {
+        Url::Url(full).strip().deparam(filter).sort_query();
+    });
+
+    Url::Url::QueryOptions options;
+    options.filter = &filter;
+    bench("parse + normalizeQuery", count, runs, [full, &options]() {
+        Url::Url(full).normalizeQuery(options);
+    });
 }
@@ -0,0 +1,103 @@
+#ifndef ARENA_CPP_H
+#define ARENA_CPP_H
+
+#include <cstddef>
+#include <new>
+#include <vector>
+
+namespace Url
+{
+
+    /**
+     * A monotonic allocator: memory is handed out from large blocks and is only ever
+     * reclaimed all at once, with `release` or on destruction.
+     *
+     * This suits data that all share a lifetime, like the URLs extracted from a single
+     * document. It is not thread-safe.
+     */
+    struct Arena
+    {
+        /**
+         * The default size of each block requested from the global allocator.
+         */
+        static const size_t DEFAULT_BLOCK_SIZE = 64 * 1024;
+
+        explicit Arena(size_t blockSize = DEFAULT_BLOCK_SIZE);
+
+        ~Arena();
+
+        /**
+         * Get size bytes aligned to alignment, which must be a power of two.
+         */
+        void* allocate(size_t size, size_t alignment = alignof(std::max_align_t));
+
+        /**
+         * Reclaim everything allocated so far. The first block is kept for reuse.
+         */
+        void release();
+
+        /**
+         * The number of bytes handed out since construction or the last release.
+         */
+        size_t allocated() const { return allocated_; }
+
+    private:
+        // Private, unimplemented to prevent use
+        Arena(const Arena& other);
+        Arena& operator=(const Arena& other);
+
+        /**
+         * Start a new block that can accommodate at least size bytes.
+         */
+        void grow(size_t size);
+
+        size_t blockSize_;
+        std::vector<char*> blocks_;
+        char* current_;
+        size_t remaining_;
+        size_t allocated_;
+    };
+
+    /**
+     * A standard allocator backed by an Arena, for use with standard containers.
+     *
+     * Deallocation is a no-op; memory is reclaimed when the arena is released.
+     */
+    template<typename T>
+    struct ArenaAllocator
+    {
+        typedef T value_type;
+
+        ArenaAllocator(Arena& arena): arena_(&arena) { }
+
+        template<typename U>
+        ArenaAllocator(const ArenaAllocator<U>& other): arena_(&other.arena()) { }
+
+        T* allocate(size_t count)
+        {
+            return static_cast<T*>(arena_->allocate(count * sizeof(T), alignof(T)));
+        }
+
+        void deallocate(T*, size_t) { }
+
+        Arena& arena() const { return *arena_; }
+
+    private:
+        Arena* arena_;
+    };
+
+    template<typename T, typename U>
+    bool operator==(const ArenaAllocator<T>& a, const ArenaAllocator<U>& b)
+    {
+        return &a.arena() == &b.arena();
+    }
+
+    template<typename T, typename U>
+    bool operator!=(const ArenaAllocator<T>& a, const ArenaAllocator<U>& b)
+    {
+        return !(a == b);
+    }
+
+}
+
+#endif
@@ -0,0 +1,165 @@
+#ifndef BASE_CPP_H
+#define BASE_CPP_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "url.h"
+
+namespace Url
+{
+
+    /**
+     * A base URL, prepared once for resolving many links against it.
+     *
+     * Resolving writes the absolute URL, exactly as Url(href).relative_to(base).str()
+     * would produce it, without building an intermediate Url. The serialized scheme
+     * and authority and the directory that relative paths are joined to are worked
+     * out ahead of time.
+     */
+    struct BaseUrl
+    {
+        /**
+         * Throws UrlParseException if the URL cannot be parsed.
+         */
+        explicit BaseUrl(const std::string& url);
+
+        explicit BaseUrl(const Url& url);
+
+        /**
+         * The base URL itself.
+         */
+        const Url& url() const { return base_; }
+
+        /**
+         * Append href, resolved against this base, to out.
+         *
+         * Returns ParseStatus::OK on success. Otherwise, href could not be parsed and out
+         * is left unchanged.
+         */
+        ParseStatus resolve(const StringView& href, std::string& out) const;
+
+        /**
+         * Set out to href resolved against this base, reusing out's buffers.
+         *
+         * Returns ParseStatus::OK on success. Otherwise, href could not be parsed and out
+         * is left unchanged.
+         */
+        ParseStatus resolve(const StringView& href, Url& out) const;
+
+    private:
+        /**
+         * Parse href into view and apply relative_to to its components. If joined is
+         * set, the view's path is still relative, and belongs after prefix_.
+         */
+        ParseStatus apply(const StringView& href, UrlView& view, bool& joined) const;
+
+        /**
+         * Work out the serialized authority and the directory prefix.
+         */
+        void prepare();
+
+        Url base_;
+
+        // Everything before the path, for URLs with the base's scheme and authority
+        std::string authority_;
+
+        // The length of the base's path, up to and including its last '/'
+        size_t directory_;
+
+        // What relative paths are appended to, and whether a '/' is needed before it
+        std::string prefix_;
+        bool slash_;
+    };
+
+    /**
+     * Which of the links found in a document resolveAll keeps.
+     */
+    struct ResolveOptions
+    {
+        ResolveOptions()
+            : schemes(scheme(Scheme::HTTP) | scheme(Scheme::HTTPS)), deduplicate(true) { }
+
+        /**
+         * The bit of schemes that keeps links with the provided scheme.
+         */
+        static uint32_t scheme(Scheme id)
+        {
+            return static_cast<uint32_t>(1) << static_cast<uint32_t>(id);
+        }
+
+        // Links are kept only if the bit for their scheme is set
+        uint32_t schemes;
+
+        // Whether to remove all but the first of identical links
+        bool deduplicate;
+    };
+
+    /**
+     * The links of a document, resolved and normalized (defragged, with absolute paths,
+     * and escaped), stored back to back. Unlike canonicalize, queries are not stripped
+     * or sorted, default ports are kept and hosts are not punycoded, so links that
+     * differ only in those ways are kept apart.
+     *
+     * Each link's bytes are in a single shared arena, and row i of every column
+     * describes the i-th link kept.
+     */
+    struct ResolvedLinks
+    {
+        /**
+         * The location of a link within the arena.
+         */
+        struct Span
+        {
+            uint32_t offset;
+            uint32_t length;
+        };
+
+        std::string arena;
+
+        std::vector<Span> links;
+
+        // The fingerprint of each link, as Url::fingerprint would give
+        std::vector<uint64_t> fingerprint;
+
+        // The index of the href each link was first resolved from
+        std::vector<uint32_t> source;
+
+        /**
+         * The number of links.
+         */
+        size_t size() const { return links.size(); }
+
+        /**
+         * Remove all links, keeping the allocated capacity for reuse.
+         */
+        void clear();
+
+        /**
+         * Get the bytes of the provided link.
+         */
+        StringView get(size_t row) const
+        {
+            const Span& span = links[row];
+            return StringView(arena.data() + span.offset, span.length);
+        }
+    };
+
+    /**
+     * Resolve count hrefs against base into out, replacing its contents.
+     *
+     * Each link is resolved, and then has its fragment removed, its path made absolute
+     * and is escaped, giving what
+     *     Url(href).relative_to(base.url()).defrag().abspath().escape().str()
+     * would. Hrefs that can't be parsed and links with schemes not in the options are
+     * skipped. Throws std::length_error if the links' combined length can't be
+     * addressed by 32-bit offsets.
+     */
+    void resolveAll(const BaseUrl& base, const StringView* hrefs, size_t count,
+        ResolvedLinks& out, const ResolveOptions& options = ResolveOptions());
+
+}
+
+#endif
@@ -0,0 +1,98 @@
+#ifndef BATCH_CPP_H
+#define BATCH_CPP_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "url.h"
+
+namespace Url
+{
+
+    /**
+     * The parsed components of many URLs, stored column-wise.
+     *
+     * The bytes of every URL are copied once into a single shared arena (with the scheme
+     * and host lowercased in place), and each component column holds the offset and
+     * length of that component within the arena. Row i of every column describes the
+     * i-th URL of the batch.
+     */
+    struct UrlBatch
+    {
+        /**
+         * The location of a run of bytes within the arena.
+         */
+        struct Span
+        {
+            uint32_t offset;
+            uint32_t length;
+        };
+
+        /**
+         * Bits of the flags column.
+         */
+        static const uint8_t HAS_PARAMS = 1 << 0;
+        static const uint8_t HAS_QUERY  = 1 << 1;
+
+        std::string arena;
+
+        // The whole URL, and each of its components
+        std::vector<Span> source;
+        std::vector<Span> scheme;
+        std::vector<Span> userinfo;
+        std::vector<Span> host;
+        std::vector<Span> path;
+        std::vector<Span> params;
+        std::vector<Span> query;
+        std::vector<Span> fragment;
+
+        std::vector<Scheme> scheme_id;
+        std::vector<uint16_t> port;
+        std::vector<uint8_t> flags;
+        std::vector<ParseStatus> status;
+
+        /**
+         * The number of rows in the batch.
+         */
+        size_t size() const { return status.size(); }
+
+        /**
+         * Remove all rows, keeping the allocated capacity for reuse.
+         */
+        void clear();
+
+        /**
+         * Reserve room for the provided number of rows and arena bytes.
+         */
+        void reserve(size_t rows, size_t bytes);
+
+        /**
+         * Get the bytes of the provided column at the provided row.
+         */
+        StringView get(const std::vector<Span>& column, size_t row) const
+        {
+            const Span& span = column[row];
+            return StringView(arena.data() + span.offset, span.length);
+        }
+
+        /**
+         * Materialize a full Url for the provided row.
+         *
+         * Throws UrlParseException if the row did not parse successfully.
+         */
+        Url url(size_t row) const;
+    };
+
+    /**
+     * Parse count URLs into out, replacing its contents.
+     *
+     * Rows that fail to parse have empty components, and their status column holds the
+     * reason. Throws std::length_error if the URLs' combined length can't be addressed
+     * by the batch's 32-bit offsets.
+     */
+    void parseBatch(const StringView* urls, size_t count, UrlBatch& out);
+
+}
+
+#endif
@@ -0,0 +1,208 @@
+#ifndef COMPACT_CPP_H
+#define COMPACT_CPP_H
+
+#include <cstdint>
+#include <string>
+#include <unordered_set>
+
+#include "arena.h"
+#include "hash.h"
+#include "url.h"
+
+namespace Url
+{
+
+    /**
+     * A memory-efficient, immutable-in-place representation of a Url.
+     *
+     * The serialized URL (exactly what Url::str() would produce) is stored once, in a
+     * single allocation of exactly that size, alongside 16-bit offsets of each component
+     * within it. Accessors return views into that buffer. Constructing from a string
+     * parses it in place, without building a Url. Transforms and setters expand to a
+     * Url, apply the transform and compact the result again, so they are best suited to
+     * occasional use. That expansion allocates from the heap, even for a CompactUrl
+     * whose buffer comes from an Arena.
+     *
+     * The serialized form must be shorter than 64KiB.
+     *
+     * The buffer may instead be allocated from an Arena, in which case the arena must
+     * outlive the CompactUrl and the buffer is only reclaimed when the arena is
+     * released. Any later assignment to an arena-backed CompactUrl allocates from the
+     * same arena, whereas copies of it use the heap.
+     */
+    struct CompactUrl
+    {
+        explicit CompactUrl(const Url& url);
+
+        explicit CompactUrl(const std::string& url);
+
+        CompactUrl(const Url& url, Arena& arena);
+
+        CompactUrl(const std::string& url, Arena& arena);
+
+        CompactUrl(const CompactUrl& other);
+
+        CompactUrl(CompactUrl&& other);
+
+        CompactUrl& operator=(const CompactUrl& other);
+
+        CompactUrl& operator=(CompactUrl&& other);
+
+        ~CompactUrl();
+
+        /**
+         * To be considered equal, all components must be equal.
+         */
+        bool operator==(const CompactUrl& other) const;
+        bool operator!=(const CompactUrl& other) const;
+
+        /**
+         * Take on the value of the provided URL.
+         */
+        CompactUrl& assign(const Url& url);
+
+        /**
+         * Expand into a full Url.
+         */
+        Url url() const;
+
+        /**************************************
+         * Component-wise access and setting. *
+         **************************************/
+        StringView scheme() const { return component(scheme_); }
+        CompactUrl& setScheme(const std::string& s);
+        Scheme schemeId() const { return scheme_id_; }
+
+        StringView host() const { return component(host_); }
+        CompactUrl& setHost(const std::string& s);
+
+        int port() const { return port_; }
+        CompactUrl& setPort(int i);
+
+        StringView path() const { return component(path_); }
+        CompactUrl& setPath(const std::string& s);
+
+        StringView params() const { return component(params_); }
+        CompactUrl& setParams(const std::string& s);
+
+        StringView query() const { return component(query_); }
+        CompactUrl& setQuery(const std::string& s);
+
+        StringView fragment() const { return component(fragment_); }
+        CompactUrl& setFragment(const std::string& s);
+
+        StringView userinfo() const { return component(userinfo_); }
+        CompactUrl& setUserinfo(const std::string& s);
+
+        /**
+         * Get a representation of all components of the path, params, query, fragment.
+         *
+         * Always includes a leading /.
+         */
+        std::string fullpath() const;
+
+        /**
+         * Get a new string representation of the URL.
+         */
+        std::string str() const { return std::string(data_, size_); }
+
+        /**
+         * Get a view of the stored string representation of the URL.
+         */
+        StringView view() const { return StringView(data_, size_); }
+
+        /**
+         * Equal to the fingerprint of the expanded Url.
+         */
+        uint64_t fingerprint() const { return Hasher::hash(data_, size_); }
+
+        /*********************
+         * Chainable methods *
+         *********************/
+        CompactUrl& strip();
+        CompactUrl& abspath();
+        CompactUrl& relative_to(const std::string& other);
+        CompactUrl& relative_to(const Url& other);
+        CompactUrl& escape(bool strict=false);
+        CompactUrl& unescape();
+        CompactUrl& deparam(const std::unordered_set<std::string>& blacklist);
+        CompactUrl& deparam(const DeparamFilter& filter);
+        CompactUrl& deparam(const Url::deparam_predicate& predicate);
+        CompactUrl& sort_query();
+        CompactUrl& remove_default_port();
+        CompactUrl& deuserinfo();
+        CompactUrl& defrag();
+        CompactUrl& punycode();
+        CompactUrl& unpunycode();
+        CompactUrl& host_reversed();
+
+    private:
+        /**
+         * The location of a component in the buffer.
+         */
+        struct Span
+        {
+            uint16_t offset;
+            uint16_t length;
+        };
+
+        /**
+         * Bits of flags_.
+         */
+        static const uint8_t HAS_PARAMS = 1 << 0;
+        static const uint8_t HAS_QUERY  = 1 << 1;
+
+        /**
+         * Get a buffer of the provided length from the arena, if any, or the heap.
+         */
+        char* allocate(size_t length);
+
+        /**
+         * Give back the current buffer, if it came from the heap.
+         */
+        void deallocate();
+
+        /**
+         * Take on the value of the view, lowercasing its scheme and host if asked to.
+         */
+        CompactUrl& assign(const UrlView& view, bool lowercase);
+
+        /**
+         * Copy the contents of other into a newly-allocated buffer.
+         */
+        void copy(const CompactUrl& other);
+
+        StringView component(const Span& span) const
+        {
+            return StringView(data_ + span.offset, span.length);
+        }
+
+        /**
+         * Expand, apply func to the expanded Url, and compact the result.
+         */
+        template<typename Func>
+        CompactUrl& apply(Func func)
+        {
+            Url expanded(url());
+            func(expanded);
+            return assign(expanded);
+        }
+
+        Arena* arena_;
+        char* data_;
+        uint16_t size_;
+        Span scheme_;
+        Span userinfo_;
+        Span host_;
+        Span path_;
+        Span params_;
+        Span query_;
+        Span fragment_;
+        uint8_t flags_;
+        Scheme scheme_id_;
+        int port_;
+    };
+
+}
+
+#endif
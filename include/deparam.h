@@ -0,0 +1,64 @@
+#ifndef DEPARAM_CPP_H
+#define DEPARAM_CPP_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+namespace Url
+{
+
+    /**
+     * A set of parameter names for Url::deparam, compiled once to be used with many URLs.
+     *
+     * Names are matched without regard to ASCII case, directly against the bytes of
+     * the URL, so that no parameter name is copied or lowercased to look it up.
+     */
+    struct DeparamFilter
+    {
+        /**
+         * Compile the provided blacklist, with the same meaning as for Url::deparam: it
+         * should contain only lowercased names, and any that are not can never match.
+         */
+        explicit DeparamFilter(const std::unordered_set<std::string>& blacklist);
+
+        /**
+         * Whether or not the provided name is in the blacklist.
+         */
+        bool contains(const char* name, size_t length) const;
+
+        /**
+         * The number of names that can match.
+         */
+        size_t size() const { return size_; }
+
+    private:
+        /**
+         * A name in the table, with its characters in names_.
+         */
+        struct Slot
+        {
+            uint64_t hash;
+            uint32_t offset;
+            uint32_t length;
+        };
+
+        // Marks a slot with no name in it
+        static const uint32_t EMPTY = UINT32_MAX;
+
+        /**
+         * Hash the provided bytes as though they were lowercased.
+         */
+        static uint64_t hash(const char* data, size_t length);
+
+        std::string names_;
+        std::vector<Slot> slots_;
+        size_t mask_;
+        size_t size_;
+    };
+
+}
+
+#endif
@@ -0,0 +1,53 @@
+#ifndef HASH_CPP_H
+#define HASH_CPP_H
+
+#include <cstddef>
+#include <cstdint>
+
+namespace Url
+{
+
+    /**
+     * The 64-bit xxHash (XXH64) of a sequence of bytes, which may be provided in pieces.
+     *
+     * Feeding the same bytes in any number of pieces produces the same hash as hashing
+     * them all at once.
+     */
+    struct Hasher
+    {
+        explicit Hasher(uint64_t seed = 0);
+
+        /**
+         * Hash the provided bytes at once.
+         */
+        static uint64_t hash(const char* data, size_t length, uint64_t seed = 0);
+
+        /**
+         * Add the provided bytes to the hash.
+         */
+        Hasher& update(const char* data, size_t length);
+
+        /**
+         * Get the hash of all the bytes provided so far.
+         */
+        uint64_t digest() const;
+
+        /**
+         * Hashers can serve as a sink for Layout::emit.
+         */
+        void operator()(const char* data, size_t length)
+        {
+            update(data, length);
+        }
+
+    private:
+        uint64_t seed_;
+        uint64_t lanes_[4];
+        uint64_t length_;
+        char buffer_[32];
+        size_t buffered_;
+    };
+
+}
+
+#endif
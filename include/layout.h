@@ -0,0 +1,156 @@
+#ifndef LAYOUT_CPP_H
+#define LAYOUT_CPP_H
+
+#include <algorithm>
+#include <cstddef>
+
+#include "url.h"
+
+namespace Url
+{
+
+    /**
+     * The serialized form of a URL, exactly as Url::str() produces it, planned out in
+     * advance.
+     *
+     * A layout knows the length of the output and where each component falls within
+     * it, so that a URL can be written in a single pass into a buffer of the right size.
+     * The view must outlive the layout.
+     */
+    struct Layout
+    {
+        explicit Layout(const UrlView& url);
+
+        /**
+         * The length of the serialized URL.
+         */
+        size_t size() const { return size_; }
+
+        /**
+         * Write the serialized URL to out, which must have room for size() bytes. If
+         * lowercase, the scheme and host are lowercased as they are written.
+         *
+         * Returns a pointer just past the last byte written.
+         */
+        char* write(char* out, bool lowercase = false) const;
+
+        /**
+         * Pass the serialized URL, a run of bytes at a time, to sink(data, length). If
+         * lowercase, the scheme and host are lowercased as they are passed on.
+         */
+        template<typename Sink>
+        void emit(Sink& sink, bool lowercase = false) const;
+
+        /**
+         * Where each component starts in the serialized URL. An empty component is
+         * placed where it would have been written.
+         */
+        size_t schemeOffset() const { return scheme_; }
+        size_t userinfoOffset() const { return userinfo_; }
+        size_t hostOffset() const { return host_; }
+        size_t pathOffset() const { return path_; }
+        size_t paramsOffset() const { return params_; }
+        size_t queryOffset() const { return query_; }
+        size_t fragmentOffset() const { return fragment_; }
+
+    private:
+        /**
+         * Pass str to sink, lowercased if requested.
+         */
+        template<typename Sink>
+        static void emit(Sink& sink, const StringView& str, bool lowercase);
+
+        const UrlView& url_;
+
+        // The separator between the scheme and what follows
+        const char* separator_;
+        size_t separatorLength_;
+
+        // The decimal text of the port, if any
+        char port_[12];
+        size_t portLength_;
+
+        // Whether a '/' is inserted before the path
+        bool slash_;
+
+        size_t scheme_;
+        size_t userinfo_;
+        size_t host_;
+        size_t path_;
+        size_t params_;
+        size_t query_;
+        size_t fragment_;
+        size_t size_;
+    };
+
+    template<typename Sink>
+    void Layout::emit(Sink& sink, bool lowercase) const
+    {
+        emit(sink, url_.scheme(), lowercase);
+        sink(separator_, separatorLength_);
+
+        if (!url_.userinfo().empty())
+        {
+            sink(url_.userinfo().data(), url_.userinfo().size());
+            sink("@", 1);
+        }
+
+        emit(sink, url_.host(), lowercase);
+
+        if (portLength_)
+        {
+            sink(":", 1);
+            sink(port_, portLength_);
+        }
+
+        if (slash_)
+        {
+            sink("/", 1);
+        }
+        sink(url_.path().data(), url_.path().size());
+
+        if (url_.hasParams())
+        {
+            sink(";", 1);
+        }
+        sink(url_.params().data(), url_.params().size());
+
+        if (url_.hasQuery())
+        {
+            sink("?", 1);
+        }
+        sink(url_.query().data(), url_.query().size());
+
+        if (!url_.fragment().empty())
+        {
+            sink("#", 1);
+        }
+        sink(url_.fragment().data(), url_.fragment().size());
+    }
+
+    template<typename Sink>
+    void Layout::emit(Sink& sink, const StringView& str, bool lowercase)
+    {
+        if (!lowercase)
+        {
+            sink(str.data(), str.size());
+            return;
+        }
+
+        // Lowercased a chunk at a time through a small buffer
+        char chunk[64];
+        for (size_t offset = 0; offset < str.size(); offset += sizeof(chunk))
+        {
+            size_t length = std::min(sizeof(chunk), str.size() - offset);
+            for (size_t index = 0; index < length; ++index)
+            {
+                char c = str[offset + index];
+                chunk[index] = (c >= 'A' && c <= 'Z') ? (c | 0x20) : c;
+            }
+            sink(chunk, length);
+        }
+    }
+
+}
+
+#endif
@@ -1,6 +1,7 @@
 #ifndef PUNYCODE_CPP_H
 #define PUNYCODE_CPP_H
 
+#include <cstdint>
 #include <stdexcept>
 #include <string>
 #include <vector>
@@ -25,39 +26,44 @@ namespace Url
         const unsigned int INITIAL_BIAS  = 72;
         const unsigned int INITIAL_N     = 128;
 
-        // Codepoints to their base-36 value
-        const std::vector<int8_t> BASIC_TO_DIGIT = {
-            -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
-            -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
-
-            -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
-            26, 27, 28, 29, 30, 31, 32, 33, 34, 35, -1, -1, -1, -1, -1, -1,
-
-            -1,  0,  1,  2,  3,  4,  5,  6,  7,  8,  9, 10, 11, 12, 13, 14,
-            15, 16, 17, 18, 19, 20, 21, 22, 23, 24, 25, -1, -1, -1, -1, -1,
-
-            -1,  0,  1,  2,  3,  4,  5,  6,  7,  8,  9, 10, 11, 12, 13, 14,
-            15, 16, 17, 18, 19, 20, 21, 22, 23, 24, 25, -1, -1, -1, -1, -1,
-
-            -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
-            -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
-
-            -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
-            -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
-
-            -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
-            -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
-
-            -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
-            -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1
-        };
-        const std::string DIGIT_TO_BASIC = "abcdefghijklmnopqrstuvwxyz0123456789";
+        // Codepoints to their base-36 value, indexed by unsigned char
+        extern const int8_t BASIC_TO_DIGIT[256];
+        const char DIGIT_TO_BASIC[] = "abcdefghijklmnopqrstuvwxyz0123456789";
 
         // The highest codepoint in unicode
         const punycode_uint MAX_PUNYCODE_UINT = std::numeric_limits<punycode_uint>::max();
         //Utf8::MAX_CODEPOINT;
         //std::numeric_limits<punycode_uint>::max();
 
+        /**
+         * The outcome of encoding or decoding.
+         */
+        enum class Status
+        {
+            OK,
+            INVALID_UTF8,
+            OVERFLOW_DELTA_UPDATE,
+            OVERFLOW_DELTA_INCREMENT,
+            NON_BASIC_CODEPOINT,
+            PREMATURE_TERMINATION,
+            INVALID_DIGIT,
+            OVERFLOW_I,
+            OVERFLOW_W,
+            OVERFLOW_N,
+            CODEPOINT_TOO_HIGH
+        };
+
+        /**
+         * A description of the provided status.
+         */
+        const char* message(Status status);
+
+        /**
+         * Write the punycoding of utf-8-encoded str into out, which must be a different
+         * string. Instead of throwing, returns the reason str could not be encoded.
+         */
+        Status encode(const std::string& str, std::string& out);
+
         /**
          * Replace utf-8-encoded str into punycode.
          */
@@ -73,6 +79,12 @@ namespace Url
          */
         std::string encodeHostname(const std::string& hostname);
 
+        /**
+         * Write the utf-8 encoding of punycoded str into out, which must be a different
+         * string. Instead of throwing, returns the reason str could not be decoded.
+         */
+        Status decode(const std::string& str, std::string& out);
+
         /**
          * Replace punycoded str into utf-8-encoded.
          */
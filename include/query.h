@@ -0,0 +1,114 @@
+#ifndef QUERY_CPP_H
+#define QUERY_CPP_H
+
+#include <cstddef>
+#include <iterator>
+#include <string>
+
+#include "url.h"
+
+namespace Url
+{
+
+    /**
+     * A read-only, non-allocating view of the key-value pairs of a query or params.
+     *
+     * The string is split on the separator ('&' for a query, ';' for params) and each
+     * piece is split at its first '=' into a key and value, as deparam does. Empty
+     * pieces hold no pair and are skipped. Keys and values refer into the viewed
+     * string, which must outlive the view, and are not decoded unless asked.
+     */
+    struct QueryView
+    {
+        /**
+         * A single key-value pair. A piece without an '=' has an empty value.
+         */
+        struct Param
+        {
+            StringView key;
+            StringView value;
+
+            /**
+             * Append the key (or value) to out, with escapes decoded.
+             */
+            void decodedKey(std::string& out) const { Url::unescaped(key, out); }
+            void decodedValue(std::string& out) const { Url::unescaped(value, out); }
+        };
+
+        /**
+         * Visits each pair in order.
+         */
+        struct iterator
+        {
+            typedef std::forward_iterator_tag iterator_category;
+            typedef Param value_type;
+            typedef std::ptrdiff_t difference_type;
+            typedef const Param* pointer;
+            typedef const Param& reference;
+
+            reference operator*() const { return param_; }
+            pointer operator->() const { return &param_; }
+
+            iterator& operator++();
+            iterator operator++(int);
+
+            bool operator==(const iterator& other) const
+            {
+                return position_ == other.position_;
+            }
+
+            bool operator!=(const iterator& other) const
+            {
+                return position_ != other.position_;
+            }
+
+        private:
+            friend struct QueryView;
+
+            iterator(const char* position, const char* end, char sep);
+
+            /**
+             * Skip empty pieces and split the piece at position_, if any.
+             */
+            void load();
+
+            const char* position_;
+            const char* next_;
+            const char* end_;
+            char sep_;
+            Param param_;
+        };
+
+        /**
+         * View the provided query (or, with a sep of ';', params).
+         */
+        explicit QueryView(const StringView& str, char sep = '&')
+            : str_(str), sep_(sep) { }
+
+        iterator begin() const;
+        iterator end() const;
+
+        /**
+         * The number of pairs.
+         */
+        size_t count() const;
+
+        /**
+         * Whether or not there is a pair with exactly the provided key.
+         */
+        bool has(const StringView& key) const;
+
+        /**
+         * The value of the first pair with exactly the provided key, or an empty view if
+         * there is none. Use has to tell a missing key from an empty value.
+         */
+        StringView get(const StringView& key) const;
+
+    private:
+        StringView str_;
+        char sep_;
+    };
+
+}
+
+#endif
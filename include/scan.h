@@ -0,0 +1,171 @@
+#ifndef SCAN_CPP_H
+#define SCAN_CPP_H
+
+#include <cstddef>
+#include <cstdint>
+
+#if defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+#include "url.h"
+
+namespace Url
+{
+
+    /**
+     * Locate URL delimiters (":/?#@;[]") a block of bytes at a time.
+     */
+    namespace Scan
+    {
+        /**
+         * Bit i of a mask corresponds to the i-th byte of a block.
+         */
+        typedef uint32_t mask_t;
+
+        /**
+         * The number of bytes classified by a single call to `delimiters`.
+         */
+#if defined(__AVX2__)
+        const size_t BLOCK_SIZE = 32;
+#else
+        const size_t BLOCK_SIZE = 16;
+#endif
+
+        /**
+         * Whether or not the provided character is a delimiter.
+         */
+        inline bool isDelimiter(char c)
+        {
+            switch (c)
+            {
+                case ':':
+                case '/':
+                case '?':
+                case '#':
+                case '@':
+                case ';':
+                case '[':
+                case ']':
+                    return true;
+                default:
+                    return false;
+            }
+        }
+
+        /**
+         * Get the mask of delimiters in the first `length` (at most BLOCK_SIZE) bytes
+         * of block, one byte at a time. This is the reference implementation, and is
+         * also used for trailing partial blocks.
+         */
+        mask_t delimitersScalar(const char* block, size_t length);
+
+        /**
+         * Get the mask of delimiters in the BLOCK_SIZE bytes starting at block.
+         */
+        inline mask_t delimiters(const char* block)
+        {
+#if defined(__AVX2__)
+            __m256i bytes = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(block));
+            __m256i hits = _mm256_or_si256(
+                _mm256_or_si256(
+                    _mm256_or_si256(
+                        _mm256_cmpeq_epi8(bytes, _mm256_set1_epi8(':')),
+                        _mm256_cmpeq_epi8(bytes, _mm256_set1_epi8('/'))),
+                    _mm256_or_si256(
+                        _mm256_cmpeq_epi8(bytes, _mm256_set1_epi8('?')),
+                        _mm256_cmpeq_epi8(bytes, _mm256_set1_epi8('#')))),
+                _mm256_or_si256(
+                    _mm256_or_si256(
+                        _mm256_cmpeq_epi8(bytes, _mm256_set1_epi8('@')),
+                        _mm256_cmpeq_epi8(bytes, _mm256_set1_epi8(';'))),
+                    _mm256_or_si256(
+                        _mm256_cmpeq_epi8(bytes, _mm256_set1_epi8('[')),
+                        _mm256_cmpeq_epi8(bytes, _mm256_set1_epi8(']')))));
+            return static_cast<mask_t>(_mm256_movemask_epi8(hits));
+#elif defined(__SSE2__)
+            __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(block));
+            __m128i hits = _mm_or_si128(
+                _mm_or_si128(
+                    _mm_or_si128(
+                        _mm_cmpeq_epi8(bytes, _mm_set1_epi8(':')),
+                        _mm_cmpeq_epi8(bytes, _mm_set1_epi8('/'))),
+                    _mm_or_si128(
+                        _mm_cmpeq_epi8(bytes, _mm_set1_epi8('?')),
+                        _mm_cmpeq_epi8(bytes, _mm_set1_epi8('#')))),
+                _mm_or_si128(
+                    _mm_or_si128(
+                        _mm_cmpeq_epi8(bytes, _mm_set1_epi8('@')),
+                        _mm_cmpeq_epi8(bytes, _mm_set1_epi8(';'))),
+                    _mm_or_si128(
+                        _mm_cmpeq_epi8(bytes, _mm_set1_epi8('[')),
+                        _mm_cmpeq_epi8(bytes, _mm_set1_epi8(']')))));
+            return static_cast<mask_t>(_mm_movemask_epi8(hits));
+#else
+            return delimitersScalar(block, BLOCK_SIZE);
+#endif
+        }
+
+        /**
+         * Visit each delimiter in [begin, end) in order, classifying a block at a time.
+         */
+        struct Delimiters
+        {
+            Delimiters(const char* begin, const char* end)
+                : block_(begin), end_(end), mask_(0)
+            {
+                load();
+            }
+
+            /**
+             * Return a pointer to the next delimiter, or end if there are no more.
+             */
+            const char* next()
+            {
+                while (!mask_)
+                {
+                    if (static_cast<size_t>(end_ - block_) <= BLOCK_SIZE)
+                    {
+                        return end_;
+                    }
+                    block_ += BLOCK_SIZE;
+                    load();
+                }
+
+                const char* result = block_ + __builtin_ctz(mask_);
+                // Clear the lowest set bit
+                mask_ &= mask_ - 1;
+                return result;
+            }
+
+        private:
+            void load()
+            {
+                size_t remaining = end_ - block_;
+                mask_ = (remaining >= BLOCK_SIZE) ?
+                    delimiters(block_) : delimitersScalar(block_, remaining);
+            }
+
+            const char* block_;
+            const char* end_;
+            mask_t mask_;
+        };
+
+        /**
+         * The number of leading bytes of data that are in safe and are not '%', and so
+         * are copied unchanged by escaping.
+         *
+         * Long runs are classified a block at a time when the CPU supports it.
+         */
+        size_t plain(const char* data, size_t length, const CharacterClass& safe);
+
+        /**
+         * The same as plain, one byte at a time. This is the reference implementation,
+         * and is also used for short runs and trailing partial blocks.
+         */
+        size_t plainScalar(const char* data, size_t length, const CharacterClass& safe);
+    };
+
+}
+
+#endif
@@ -0,0 +1,107 @@
+#ifndef SCHEME_CPP_H
+#define SCHEME_CPP_H
+
+#include <cstddef>
+#include <cstdint>
+
+namespace Url
+{
+
+    /**
+     * The schemes whose behavior is known. Any other scheme is UNKNOWN, and NONE is the
+     * absence of a scheme.
+     */
+    enum class Scheme : uint8_t
+    {
+        NONE,
+        FILE,
+        FTP,
+        GIT,
+        GIT_SSH,
+        GOPHER,
+        HDL,
+        HTTP,
+        HTTPS,
+        IMAP,
+        MMS,
+        NFS,
+        NNTP,
+        PROSPERO,
+        RSYNC,
+        RTSP,
+        RTSPU,
+        SFTP,
+        SHTTP,
+        SIP,
+        SIPS,
+        SMS,
+        SNEWS,
+        SVN,
+        SVN_SSH,
+        TEL,
+        TELNET,
+        WAIS,
+        UNKNOWN
+    };
+
+    /**
+     * Classify schemes and look up their properties.
+     */
+    struct Schemes
+    {
+        /**
+         * Bits of the flags of a scheme, mirroring membership in Url::USES_RELATIVE,
+         * Url::USES_NETLOC, Url::USES_PARAMS and Url::KNOWN_PROTOCOLS.
+         */
+        static const uint8_t USES_RELATIVE = 1 << 0;
+        static const uint8_t USES_NETLOC   = 1 << 1;
+        static const uint8_t USES_PARAMS   = 1 << 2;
+        static const uint8_t KNOWN         = 1 << 3;
+
+        /**
+         * Identify the scheme exactly as written.
+         */
+        static Scheme classify(const char* data, size_t length);
+
+        /**
+         * Identify the scheme, ignoring the case of ASCII letters.
+         */
+        static Scheme classifyInsensitive(const char* data, size_t length);
+
+        /**
+         * Get the flags of the provided scheme.
+         */
+        static uint8_t flags(Scheme scheme)
+        {
+            return FLAGS[static_cast<size_t>(scheme)];
+        }
+
+        /**
+         * Get the default port of the provided scheme, or 0 if it has none.
+         */
+        static int defaultPort(Scheme scheme)
+        {
+            return scheme == Scheme::HTTP ? 80 : (scheme == Scheme::HTTPS ? 443 : 0);
+        }
+
+        /**
+         * Get the lowercase name of the provided scheme. UNKNOWN has an empty name.
+         */
+        static const char* name(Scheme scheme)
+        {
+            return NAMES[static_cast<size_t>(scheme)];
+        }
+
+    private:
+        static const uint8_t FLAGS[];
+        static const char* const NAMES[];
+
+        /**
+         * Look up a scheme by up to 8 bytes packed into an integer.
+         */
+        static Scheme lookup(uint64_t packed, size_t length);
+    };
+
+}
+
+#endif
@@ -1,6 +1,9 @@
 #ifndef URL_CPP_H
 #define URL_CPP_H
 
+#include <cassert>
+#include <cstdint>
+#include <cstring>
 #include <stdexcept>
 #include <functional>
 #include <string>
@@ -8,32 +11,96 @@
 #include <unordered_map>
 #include <unordered_set>
 
+#include "scheme.h"
+
 namespace Url
 {
 
+    /**
+     * The outcome of parsing a URL.
+     */
+    enum class ParseStatus
+    {
+        OK,
+        PORT_NOT_NUMBER,
+        PORT_OUT_OF_RANGE,
+        PORT_TOO_HIGH,
+        PORT_NEGATIVE
+    };
+
     struct UrlParseException : public std::logic_error
     {
-        UrlParseException(const std::string& message) : std::logic_error(message) {}
+        UrlParseException(const std::string& message)
+            : std::logic_error(message), status_(ParseStatus::OK) {}
+
+        /**
+         * A failed parse, described by the status and the text of the offending port.
+         */
+        UrlParseException(ParseStatus status, const std::string& port)
+            : std::logic_error(std::string(message(status)) + ": " + port), status_(status) {}
+
+        /**
+         * The reason parsing failed, if the exception came from a parse.
+         */
+        ParseStatus status() const { return status_; }
+
+        /**
+         * A description of the provided status.
+         */
+        static const char* message(ParseStatus status);
+
+    private:
+        ParseStatus status_;
     };
 
+    struct BaseUrl;
+    struct DeparamFilter;
+
+    /**
+     * A set of bytes, stored as a 256-bit set so that it can be built at compile time.
+     *
+     * The provided characters must outlive the class, as string literals do.
+     */
     struct CharacterClass
     {
-        CharacterClass(const std::string& chars) : chars_(chars), map_(256, false)
+        constexpr CharacterClass(const char* chars)
+            : chars_(chars)
+            , bits_{ word(chars, 0), word(chars, 1), word(chars, 2), word(chars, 3) }
+            , nibbles_{
+                nibble(chars, 0x0), nibble(chars, 0x1), nibble(chars, 0x2),
+                nibble(chars, 0x3), nibble(chars, 0x4), nibble(chars, 0x5),
+                nibble(chars, 0x6), nibble(chars, 0x7), nibble(chars, 0x8),
+                nibble(chars, 0x9), nibble(chars, 0xA), nibble(chars, 0xB),
+                nibble(chars, 0xC), nibble(chars, 0xD), nibble(chars, 0xE),
+                nibble(chars, 0xF) } { }
+
+        constexpr bool operator()(char c) const
         {
-            for (auto it = chars_.begin(); it != chars_.end(); ++it)
-            {
-                map_[static_cast<size_t>(*it)] = true;
-            }
+            return (bits_[static_cast<unsigned char>(c) >> 6]
+                >> (static_cast<unsigned char>(c) & 63)) & 1;
         }
 
-        bool operator()(char c) const
+        constexpr const char* chars() const
         {
-            return map_[static_cast<unsigned char>(c)];
+            return chars_;
         }
 
-        const std::string& chars() const
+        /**
+         * Whether or not the set holds only ASCII characters.
+         */
+        constexpr bool ascii() const
         {
-            return chars_;
+            return !(bits_[2] | bits_[3]);
+        }
+
+        /**
+         * The ASCII part of the set, indexed by low nibble, with bit i set for each
+         * member whose high nibble is i. This is the form used to classify many bytes at
+         * once with table lookups.
+         */
+        constexpr const uint8_t* nibbles() const
+        {
+            return nibbles_;
         }
 
     private:
@@ -41,8 +108,209 @@ namespace Url
         CharacterClass();
         CharacterClass(const CharacterClass& other);
 
-        std::string chars_;
-        std::vector<bool> map_;
+        /**
+         * The bits of the index-th 64-character word of the set of chars.
+         */
+        static constexpr uint64_t word(const char* chars, size_t index)
+        {
+            return *chars == '\0' ? 0 : (
+                ((static_cast<unsigned char>(*chars) >> 6) != index ? 0 :
+                    (uint64_t(1) << (static_cast<unsigned char>(*chars) & 63)))
+                | word(chars + 1, index));
+        }
+
+        /**
+         * The high-nibble bits of the ASCII chars with the provided low nibble.
+         */
+        static constexpr uint8_t nibble(const char* chars, unsigned char low)
+        {
+            return *chars == '\0' ? 0 : (
+                ((static_cast<unsigned char>(*chars) & 0x8F) != low ? 0 :
+                    (1 << (static_cast<unsigned char>(*chars) >> 4)))
+                | nibble(chars + 1, low));
+        }
+
+        const char* chars_;
+        uint64_t bits_[4];
+        uint8_t nibbles_[16];
+    };
+
+    /**
+     * A non-owning reference to a run of characters in someone else's buffer.
+     */
+    struct StringView
+    {
+        StringView(): data_(nullptr), size_(0) { }
+
+        StringView(const char* data, size_t size): data_(data), size_(size) { }
+
+        StringView(const char* str): data_(str), size_(std::strlen(str)) { }
+
+        StringView(const std::string& str): data_(str.data()), size_(str.size()) { }
+
+        const char* data() const { return data_; }
+        size_t size() const { return size_; }
+        bool empty() const { return size_ == 0; }
+
+        const char* begin() const { return data_; }
+        const char* end() const { return data_ + size_; }
+
+        char operator[](size_t index) const { return data_[index]; }
+
+        /**
+         * Get an owning copy of the referenced characters.
+         */
+        std::string str() const { return std::string(data_, size_); }
+
+    private:
+        const char* data_;
+        size_t size_;
+    };
+
+    inline bool operator==(const StringView& a, const StringView& b)
+    {
+        // An empty view may have a null data pointer, which memcmp must not be given
+        return a.size() == b.size() &&
+            (a.size() == 0 || std::memcmp(a.data(), b.data(), a.size()) == 0);
+    }
+
+    inline bool operator!=(const StringView& a, const StringView& b)
+    {
+        return !(a == b);
+    }
+
+    /**
+     * A read-only, non-allocating parse of a URL.
+     *
+     * Components are parsed with the same rules as Url, but are stored as references
+     * into the provided buffer, which must outlive the view. Unlike Url, the scheme and
+     * host are exactly as they appear in the input and are not lowercased.
+     */
+    struct UrlView
+    {
+        /**
+         * An empty view.
+         */
+        UrlView();
+
+        explicit UrlView(const std::string& url);
+
+        explicit UrlView(const char* url);
+
+        UrlView(const char* data, size_t length);
+
+        // Views of temporaries would dangle immediately.
+        UrlView(std::string&& url) = delete;
+
+        StringView scheme() const { return scheme_; }
+        StringView userinfo() const { return userinfo_; }
+
+        /**
+         * The scheme, classified regardless of case.
+         */
+        Scheme schemeId() const { return scheme_id_; }
+
+        StringView host() const { return host_; }
+        int port() const { return port_; }
+        StringView path() const { return path_; }
+        StringView params() const { return params_; }
+        StringView query() const { return query_; }
+        StringView fragment() const { return fragment_; }
+
+        /**
+         * Whether or not a ';' or '?' delimiter (respectively) was present.
+         */
+        bool hasParams() const { return has_params_; }
+        bool hasQuery() const { return has_query_; }
+
+        /**
+         * Parse the provided buffer into out without throwing.
+         *
+         * Returns ParseStatus::OK on success. Otherwise, out is left in an unspecified
+         * state and should not be used.
+         */
+        static ParseStatus parse(const char* data, size_t length, UrlView& out);
+
+        /**
+         * The fingerprint of the Url this view would produce, without producing it.
+         */
+        uint64_t fingerprint() const;
+
+        /**
+         * Append the path to out, with escapes decoded as Url::unescape would.
+         */
+        void unescapedPath(std::string& out) const;
+
+    private:
+        // Url provides views of its own components
+        friend struct Url;
+
+        // BaseUrl fills in components inherited from the base
+        friend struct BaseUrl;
+
+        /**
+         * Populate all the components from the provided buffer.
+         */
+        ParseStatus parse_components(const char* data, size_t length);
+
+        /**
+         * Parse the text of a port in [begin, end) into port.
+         */
+        static ParseStatus parse_port(const char* begin, const char* end, int& port);
+
+        StringView scheme_;
+        Scheme scheme_id_;
+        StringView userinfo_;
+        StringView host_;
+        int port_;
+        StringView path_;
+        StringView params_;
+        StringView query_;
+        StringView fragment_;
+        bool has_params_;
+        bool has_query_;
+    };
+
+    /**
+     * The canonical form of a URL as used by Url::equiv, reduced to a hash and,
+     * optionally, an encoding of the canonical components from which it was computed.
+     *
+     * Two URLs are equivalent exactly when their keys are equal. Keys with bytes compare
+     * by hash and then by bytes. Keys without bytes compare by hash alone, so they are
+     * cheaper to keep but are subject to (64-bit) hash collisions. Only keys of the same
+     * kind may be compared with each other.
+     */
+    struct CanonicalKey
+    {
+        CanonicalKey(): hash_(0), bytes_() { }
+
+        uint64_t hash() const { return hash_; }
+
+        /**
+         * The encoded canonical components, or empty if they were not kept.
+         */
+        const std::string& bytes() const { return bytes_; }
+
+        /**
+         * Either both keys or neither must have bytes.
+         */
+        bool operator==(const CanonicalKey& other) const
+        {
+            assert(bytes_.empty() == other.bytes_.empty());
+            return hash_ == other.hash_ && bytes_ == other.bytes_;
+        }
+
+        bool operator!=(const CanonicalKey& other) const
+        {
+            return !operator==(other);
+        }
+
+    private:
+        // Url computes keys of itself
+        friend struct Url;
+
+        uint64_t hash_;
+        std::string bytes_;
     };
 
     struct Url
@@ -61,7 +329,7 @@ namespace Url
         const static CharacterClass USERINFO;
         const static CharacterClass HEX;
         const static CharacterClass SCHEME;
-        const static std::vector<signed char> HEX_TO_DEC;
+        const static signed char HEX_TO_DEC[256];
         const static std::unordered_map<std::string, int> PORTS;
         const static std::unordered_set<std::string> USES_RELATIVE;
         const static std::unordered_set<std::string> USES_NETLOC;
@@ -71,10 +339,38 @@ namespace Url
         // The type of the predicate used for removing parameters
         typedef std::function<bool(std::string&, std::string&)> deparam_predicate;
 
+        /**
+         * What normalizeQuery does besides stripping.
+         */
+        struct QueryOptions
+        {
+            QueryOptions(): filter(nullptr), sort(true), deduplicate(false) { }
+
+            // If provided, pairs with names in the filter are removed
+            const DeparamFilter* filter;
+
+            // Whether to put the pairs in sorted order
+            bool sort;
+
+            // Whether to remove all but the first of identical pairs
+            bool deduplicate;
+        };
+
+        /**
+         * An empty URL, to be populated with reset or parse.
+         */
+        Url();
+
         explicit Url(const std::string& url);
 
+        /**
+         * Take on owning copies of all of the view's components.
+         */
+        explicit Url(const UrlView& view);
+
         Url(const Url& other)
             : scheme_(other.scheme_)
+            , scheme_id_(other.scheme_id_)
             , host_(other.host_)
             , port_(other.port_)
             , path_(other.path_)
@@ -85,11 +381,39 @@ namespace Url
             , has_params_(other.has_params_)
             , has_query_(other.has_query_) { }
 
+        /**
+         * Parse the provided buffer into out without throwing.
+         *
+         * Returns ParseStatus::OK on success. Otherwise, out is left in an unspecified
+         * state and should not be used.
+         */
+        static ParseStatus parse(const char* data, size_t length, Url& out);
+
+        /**
+         * Append str to out with its escapes decoded, as unescape would decode them.
+         */
+        static void unescaped(const StringView& str, std::string& out);
+
+        /**
+         * Parse the provided URL into this object, reusing the storage of the existing
+         * components where possible.
+         *
+         * Throws UrlParseException on failure, after which this URL is left in an
+         * unspecified state.
+         */
+        Url& reset(const StringView& url);
+
         /**
          * Take on the value of the other URL.
          */
         Url& assign(const Url& other);
 
+        /**
+         * Take on owning copies of all of the view's components, reusing the existing
+         * storage where possible.
+         */
+        Url& assign(const UrlView& view);
+
         /**
          * To be considered equal, all fields must be equal.
          */
@@ -98,8 +422,19 @@ namespace Url
 
         /**
          * Two URLs are considered equivalent if they have the same meaning.
+         *
+         * To compare one URL against many, compute each canonicalKey once instead.
+         */
+        bool equiv(const Url& other) const;
+
+        /**
+         * The key of this URL's canonical form, computed without modifying or copying
+         * the URL. Two URLs are equiv exactly when their keys are equal. Unless
+         * keepBytes is true, the key holds only the hash.
+         *
+         * Like canonicalize, throws std::invalid_argument if the hostname is invalid.
          */
-        bool equiv(const Url& other);
+        CanonicalKey canonicalKey(bool keepBytes=true) const;
 
         /**************************************
          * Component-wise access and setting. *
@@ -108,9 +443,15 @@ namespace Url
         Url& setScheme(const std::string& s)
         {
             scheme_ = s;
+            scheme_id_ = Schemes::classify(s.data(), s.size());
             return *this;
         }
 
+        /**
+         * The scheme, classified exactly as it is written.
+         */
+        Scheme schemeId() const { return scheme_id_; }
+
         const std::string& host() const { return host_; }
         Url& setHost(const std::string& s)
         {
@@ -169,15 +510,55 @@ namespace Url
          */
         std::string fullpath() const;
 
+        /**
+         * Append the representation of all components of the path, params, query and
+         * fragment to out.
+         */
+        void fullpath(std::string& out) const;
+
         /**
          * Get a new string representation of the URL.
          **/
         std::string str() const;
 
+        /**
+         * Append the string representation of the URL to out.
+         */
+        void str(std::string& out) const;
+
+        /**
+         * Write the string representation of the URL to buffer, if it fits within
+         * capacity bytes. No terminating NUL is written.
+         *
+         * Returns the length of the representation whether or not it was written.
+         */
+        size_t write(char* buffer, size_t capacity) const;
+
+        /**
+         * Get a view of this URL's components, valid until the URL is next modified.
+         */
+        UrlView view() const;
+
+        /**
+         * A 64-bit hash of the URL, equal to Hasher::hash of str(), computed without
+         * building the string.
+         */
+        uint64_t fingerprint() const;
+
         /*********************
          * Chainable methods *
          *********************/
 
+        /**
+         * Put the URL into the canonical form used by equiv.
+         *
+         * The result is exactly that of strip, sort_query, defrag, deuserinfo, abspath,
+         * escape, punycode and remove_default_port in turn, but is computed in a single
+         * pass over each component. Like punycode, throws std::invalid_argument if the
+         * hostname is invalid.
+         */
+        Url& canonicalize();
+
         /**
          * Strip semantically meaningless excess '?', '&', and ';' characters from query
          * and params.
@@ -225,6 +606,13 @@ namespace Url
          */
         Url& deparam(const std::unordered_set<std::string>& blacklist);
 
+        /**
+         * Remove any params or queries whose names are in the compiled blacklist. This is
+         * the same as deparam with the blacklist the filter was built from, but without
+         * copying any parameter names.
+         */
+        Url& deparam(const DeparamFilter& filter);
+
         /**
          * Filter params subject to a predicate for whether it should be filtered.
          *
@@ -241,6 +629,15 @@ namespace Url
          */
         Url& sort_query();
 
+        /**
+         * Strip, filter and sort the query and params in a single pass over each.
+         *
+         * The result is identical to strip, then deparam with the filter (if any), then
+         * sort_query (if sorting). With deduplicate, only the first of any identical
+         * pairs is kept.
+         */
+        Url& normalizeQuery(const QueryOptions& options = QueryOptions());
+
         /**
          * Remove the port if it's the default for the scheme.
          */
@@ -272,8 +669,11 @@ namespace Url
         Url& host_reversed();
 
     private:
-        // Private, unimplemented to prevent use.
-        Url();
+        // CompactUrl reconstructs a Url directly from its components
+        friend struct CompactUrl;
+
+        // BaseUrl joins relative paths onto its directory in place
+        friend struct BaseUrl;
 
         /**
          * Remove repeated, leading, and trailing instances of chr from the string.
@@ -304,9 +704,10 @@ namespace Url
         /**
          * Check that the hostname is valid, removing an optional trailing '.'.
          */
-        void check_hostname(std::string& host);
+        static void check_hostname(std::string& host);
 
         std::string scheme_;
+        Scheme scheme_id_;
         std::string host_;
         int port_;
         std::string path_;
@@ -320,4 +721,33 @@ namespace Url
 
 }
 
+namespace std
+{
+
+    /**
+     * Hash URLs by their fingerprint.
+     */
+    template<>
+    struct hash<Url::Url>
+    {
+        size_t operator()(const Url::Url& url) const
+        {
+            return static_cast<size_t>(url.fingerprint());
+        }
+    };
+
+    /**
+     * Hash canonical keys by their hash.
+     */
+    template<>
+    struct hash<Url::CanonicalKey>
+    {
+        size_t operator()(const Url::CanonicalKey& key) const
+        {
+            return static_cast<size_t>(key.hash());
+        }
+    };
+
+}
+
 #endif
@@ -28,12 +28,40 @@ namespace Url
          */
         static const codepoint_t MAX_CODEPOINT = 0x10FFFF;
 
+        /**
+         * The outcome of reading or writing a codepoint.
+         */
+        enum class Status
+        {
+            OK,
+            LOW_START_BYTE,
+            HIGH_START_BYTE,
+            TERMINATED_EARLY,
+            INVALID_CONTINUATION,
+            CODEPOINT_TOO_HIGH
+        };
+
+        /**
+         * A description of the provided status.
+         */
+        static const char* message(Status status);
+
         /**
          * Consume up to the last byte of the sequence, returning the codepoint.
          */
         static codepoint_t readCodepoint(
             std::string::const_iterator& it, const std::string::const_iterator& end);
 
+        /**
+         * Consume up to the last byte of the sequence, placing the codepoint in value.
+         *
+         * Instead of throwing, returns the reason the sequence is invalid.
+         */
+        static Status readCodepoint(
+            std::string::const_iterator& it,
+            const std::string::const_iterator& end,
+            codepoint_t& value);
+
         /**
          * Write a codepoint to the provided string.
          */
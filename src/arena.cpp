@@ -0,0 +1,69 @@
+#include <algorithm>
+#include <cstdint>
+
+#include "arena.h"
+
+namespace Url
+{
+
+    Arena::Arena(size_t blockSize)
+        : blockSize_(blockSize), current_(nullptr), remaining_(0), allocated_(0) { }
+
+    Arena::~Arena()
+    {
+        for (auto it = blocks_.begin(); it != blocks_.end(); ++it)
+        {
+            delete[] *it;
+        }
+    }
+
+    void* Arena::allocate(size_t size, size_t alignment)
+    {
+        size_t padding = (alignment - (reinterpret_cast<uintptr_t>(current_) & (alignment - 1)))
+            & (alignment - 1);
+        if (!current_ || (padding + size) > remaining_)
+        {
+            // Fresh blocks come from new[], which is suitably aligned for anything
+            grow(size);
+            padding = 0;
+        }
+
+        char* result = current_ + padding;
+        current_ += padding + size;
+        remaining_ -= padding + size;
+        allocated_ += size;
+        return result;
+    }
+
+    void Arena::release()
+    {
+        if (blocks_.empty())
+        {
+            return;
+        }
+
+        for (auto it = blocks_.begin() + 1; it != blocks_.end(); ++it)
+        {
+            delete[] *it;
+        }
+        blocks_.resize(1);
+        current_ = blocks_.front();
+        remaining_ = blockSize_;
+        allocated_ = 0;
+    }
+
+    void Arena::grow(size_t size)
+    {
+        // Requests larger than a block get a block of their own
+        size_t length = std::max(size, blockSize_);
+        if (blocks_.empty() && length > blockSize_)
+        {
+            // The first block is kept on release, so it must be of the standard size
+            blocks_.push_back(new char[blockSize_]);
+        }
+        blocks_.push_back(new char[length]);
+        current_ = blocks_.back();
+        remaining_ = length;
+    }
+
+};
@@ -0,0 +1,305 @@
+#include <algorithm>
+#include <limits>
+#include <stdexcept>
+
+#include "base.h"
+#include "hash.h"
+#include "layout.h"
+
+namespace Url
+{
+
+    namespace
+    {
+        /**
+         * Append the view to out, lowercasing the scheme and host as Url does.
+         */
+        void append(const UrlView& view, std::string& out)
+        {
+            Layout layout(view);
+            size_t start = out.size();
+            out.resize(start + layout.size());
+            layout.write(&out[start], true);
+        }
+    }
+
+    BaseUrl::BaseUrl(const std::string& url)
+        : base_(url), authority_(), directory_(0), prefix_(), slash_(false)
+    {
+        prepare();
+    }
+
+    BaseUrl::BaseUrl(const Url& url)
+        : base_(url), authority_(), directory_(0), prefix_(), slash_(false)
+    {
+        prepare();
+    }
+
+    void BaseUrl::prepare()
+    {
+        const std::string& scheme = base_.scheme();
+        const std::string& host = base_.host();
+
+        authority_.append(scheme);
+        if (!scheme.empty())
+        {
+            authority_.append(
+                (Schemes::flags(base_.schemeId()) & Schemes::USES_NETLOC) ? "://" : ":");
+        }
+        else if (!host.empty())
+        {
+            authority_.append("//");
+        }
+        if (!base_.userinfo().empty())
+        {
+            authority_.append(base_.userinfo()).append(1, '@');
+        }
+        authority_.append(host);
+        if (base_.port())
+        {
+            authority_.append(1, ':').append(std::to_string(base_.port()));
+        }
+
+        // Relative paths are joined to the directory, or made absolute if there is none
+        const std::string& path = base_.path();
+        size_t index = path.rfind('/');
+        directory_ = (index == std::string::npos) ? 0 : index + 1;
+        if (directory_)
+        {
+            prefix_.assign(path, 0, directory_);
+        }
+        else if (!host.empty())
+        {
+            prefix_.assign("/");
+        }
+        slash_ = !host.empty() && prefix_[0] != '/';
+    }
+
+    ParseStatus BaseUrl::apply(const StringView& href, UrlView& view, bool& joined) const
+    {
+        joined = false;
+        ParseStatus status = UrlView::parse(href.data(), href.size(), view);
+        if (status != ParseStatus::OK)
+        {
+            return status;
+        }
+
+        // What follows is relative_to, applied to the view's components
+        if (!(Schemes::flags(view.schemeId()) & Schemes::USES_RELATIVE))
+        {
+            return status;
+        }
+
+        if (view.scheme().empty())
+        {
+            view.scheme_ = StringView(base_.scheme());
+            view.scheme_id_ = base_.schemeId();
+        }
+
+        if (!view.host().empty())
+        {
+            return status;
+        }
+
+        view.host_ = StringView(base_.host());
+        view.port_ = base_.port();
+        view.userinfo_ = StringView(base_.userinfo());
+
+        if (!view.path().empty() && view.path()[0] == '/')
+        {
+            return status;
+        }
+
+        if (view.path().empty())
+        {
+            if (view.params().empty())
+            {
+                UrlView base = base_.view();
+                view.path_ = base.path();
+                view.params_ = base.params();
+                view.has_params_ = base.hasParams();
+                if (view.query().empty())
+                {
+                    view.query_ = base.query();
+                    view.has_query_ = base.hasQuery();
+                }
+            }
+            else
+            {
+                view.path_ = StringView(base_.path().data(), directory_);
+            }
+
+            if (view.fragment().empty())
+            {
+                view.fragment_ = StringView(base_.fragment());
+            }
+            return status;
+        }
+
+        joined = true;
+        return status;
+    }
+
+    ParseStatus BaseUrl::resolve(const StringView& href, std::string& out) const
+    {
+        UrlView view;
+        bool joined;
+        ParseStatus status = apply(href, view, joined);
+        if (status != ParseStatus::OK)
+        {
+            return status;
+        }
+
+        if (!joined)
+        {
+            append(view, out);
+            return status;
+        }
+
+        // Only a scheme taken from the base points into it
+        if (view.scheme().data() != base_.scheme().data())
+        {
+            // A scheme of its own, but the base's authority, which is rare enough to
+            // join the path separately
+            std::string path(prefix_);
+            path.append(view.path().data(), view.path().size());
+            view.path_ = StringView(path);
+            append(view, out);
+            return status;
+        }
+
+        // The most common case: a relative path, written after the prepared prefix
+        out.reserve(out.size() + authority_.size() + (slash_ ? 1 : 0) + prefix_.size()
+            + view.path().size()
+            + (view.hasParams() ? 1 : 0) + view.params().size()
+            + (view.hasQuery() ? 1 : 0) + view.query().size()
+            + (view.fragment().empty() ? 0 : 1) + view.fragment().size());
+        out.append(authority_);
+        if (slash_)
+        {
+            out.append(1, '/');
+        }
+        out.append(prefix_);
+        out.append(view.path().data(), view.path().size());
+        if (view.hasParams())
+        {
+            out.append(1, ';');
+        }
+        out.append(view.params().data(), view.params().size());
+        if (view.hasQuery())
+        {
+            out.append(1, '?');
+        }
+        out.append(view.query().data(), view.query().size());
+        if (!view.fragment().empty())
+        {
+            out.append(1, '#');
+        }
+        out.append(view.fragment().data(), view.fragment().size());
+        return status;
+    }
+
+    ParseStatus BaseUrl::resolve(const StringView& href, Url& out) const
+    {
+        UrlView view;
+        bool joined;
+        ParseStatus status = apply(href, view, joined);
+        if (status != ParseStatus::OK)
+        {
+            return status;
+        }
+
+        out.assign(view);
+        if (joined)
+        {
+            out.path_.insert(0, prefix_);
+        }
+        return status;
+    }
+
+    void ResolvedLinks::clear()
+    {
+        arena.clear();
+        links.clear();
+        fingerprint.clear();
+        source.clear();
+    }
+
+    void resolveAll(const BaseUrl& base, const StringView* hrefs, size_t count,
+        ResolvedLinks& out, const ResolveOptions& options)
+    {
+        out.clear();
+        out.links.reserve(count);
+        out.fingerprint.reserve(count);
+        out.source.reserve(count);
+
+        // Row + 1 of each link seen, by fingerprint, in a table at most half full
+        std::vector<uint32_t> table;
+        size_t mask = 0;
+        if (options.deduplicate)
+        {
+            size_t capacity = 8;
+            while (capacity < 2 * count)
+            {
+                capacity *= 2;
+            }
+            table.assign(capacity, 0);
+            mask = capacity - 1;
+        }
+
+        // Reused for every link, so that its buffers are only allocated once
+        Url url;
+
+        for (size_t index = 0; index < count; ++index)
+        {
+            if (base.resolve(hrefs[index], url) != ParseStatus::OK
+                || !(options.schemes & ResolveOptions::scheme(url.schemeId())))
+            {
+                continue;
+            }
+
+            url.defrag().abspath().escape();
+            size_t offset = out.arena.size();
+            url.str(out.arena);
+            size_t length = out.arena.size() - offset;
+            if (out.arena.size() > std::numeric_limits<uint32_t>::max())
+            {
+                // Exercising this requires gigabytes of links
+                throw std::length_error("Links too large for 32-bit offsets."); // LCOV_EXCL_LINE
+            }
+
+            const char* data = out.arena.data() + offset;
+            uint64_t fingerprint = Hasher::hash(data, length);
+            if (options.deduplicate)
+            {
+                size_t slot = fingerprint & mask;
+                bool duplicate = false;
+                while (table[slot])
+                {
+                    size_t row = table[slot] - 1;
+                    const ResolvedLinks::Span& span = out.links[row];
+                    if (out.fingerprint[row] == fingerprint && span.length == length
+                        && std::equal(data, data + length, out.arena.data() + span.offset))
+                    {
+                        duplicate = true;
+                        break;
+                    }
+                    slot = (slot + 1) & mask;
+                }
+
+                if (duplicate)
+                {
+                    out.arena.resize(offset);
+                    continue;
+                }
+                table[slot] = static_cast<uint32_t>(out.links.size() + 1);
+            }
+
+            out.links.push_back({
+                static_cast<uint32_t>(offset), static_cast<uint32_t>(length) });
+            out.fingerprint.push_back(fingerprint);
+            out.source.push_back(static_cast<uint32_t>(index));
+        }
+    }
+
+};
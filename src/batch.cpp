@@ -0,0 +1,125 @@
+#include <algorithm>
+#include <limits>
+#include <stdexcept>
+
+#include "batch.h"
+
+namespace Url
+{
+
+    void UrlBatch::clear()
+    {
+        arena.clear();
+        source.clear();
+        scheme.clear();
+        userinfo.clear();
+        host.clear();
+        path.clear();
+        params.clear();
+        query.clear();
+        fragment.clear();
+        scheme_id.clear();
+        port.clear();
+        flags.clear();
+        status.clear();
+    }
+
+    void UrlBatch::reserve(size_t rows, size_t bytes)
+    {
+        arena.reserve(bytes);
+        source.reserve(rows);
+        scheme.reserve(rows);
+        userinfo.reserve(rows);
+        host.reserve(rows);
+        path.reserve(rows);
+        params.reserve(rows);
+        query.reserve(rows);
+        fragment.reserve(rows);
+        scheme_id.reserve(rows);
+        port.reserve(rows);
+        flags.reserve(rows);
+        status.reserve(rows);
+    }
+
+    Url UrlBatch::url(size_t row) const
+    {
+        // The arena holds the (partially-lowercased) original, which parses the same way
+        const Span& span = source[row];
+        return Url(UrlView(arena.data() + span.offset, span.length));
+    }
+
+    void parseBatch(const StringView* urls, size_t count, UrlBatch& out)
+    {
+        size_t bytes = 0;
+        for (size_t row = 0; row < count; ++row)
+        {
+            bytes += urls[row].size();
+        }
+
+        if (bytes > std::numeric_limits<uint32_t>::max())
+        {
+            // Exercising this requires gigabytes of input
+            throw std::length_error("Batch too large for 32-bit offsets."); // LCOV_EXCL_LINE
+        }
+
+        out.clear();
+        out.reserve(count, bytes);
+
+        UrlView view;
+        for (size_t row = 0; row < count; ++row)
+        {
+            const StringView& url = urls[row];
+            uint32_t base = static_cast<uint32_t>(out.arena.size());
+            out.arena.append(url.data(), url.size());
+            out.source.push_back({ base, static_cast<uint32_t>(url.size()) });
+
+            ParseStatus status = UrlView::parse(url.data(), url.size(), view);
+            out.status.push_back(status);
+            if (status != ParseStatus::OK)
+            {
+                view = UrlView();
+            }
+
+            // Each component is either empty or lies within the URL
+            auto locate = [&url, base](const StringView& component) -> UrlBatch::Span
+            {
+                if (component.empty())
+                {
+                    return { base, 0 };
+                }
+                return {
+                    static_cast<uint32_t>(base + (component.data() - url.data())),
+                    static_cast<uint32_t>(component.size())
+                };
+            };
+
+            out.scheme.push_back(locate(view.scheme()));
+            out.userinfo.push_back(locate(view.userinfo()));
+            out.host.push_back(locate(view.host()));
+            out.path.push_back(locate(view.path()));
+            out.params.push_back(locate(view.params()));
+            out.query.push_back(locate(view.query()));
+            out.fragment.push_back(locate(view.fragment()));
+            out.scheme_id.push_back(view.schemeId());
+            out.port.push_back(static_cast<uint16_t>(view.port()));
+            out.flags.push_back(
+                (view.hasParams() ? UrlBatch::HAS_PARAMS : 0) |
+                (view.hasQuery() ? UrlBatch::HAS_QUERY : 0));
+
+            // Lowercase the scheme and host in place
+            const UrlBatch::Span& scheme = out.scheme.back();
+            const UrlBatch::Span& host = out.host.back();
+            std::transform(
+                out.arena.begin() + scheme.offset,
+                out.arena.begin() + scheme.offset + scheme.length,
+                out.arena.begin() + scheme.offset,
+                ::tolower);
+            std::transform(
+                out.arena.begin() + host.offset,
+                out.arena.begin() + host.offset + host.length,
+                out.arena.begin() + host.offset,
+                ::tolower);
+        }
+    }
+
+};
@@ -0,0 +1,357 @@
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+#include <utility>
+
+#include "compact.h"
+#include "layout.h"
+
+namespace Url
+{
+
+    CompactUrl::CompactUrl(const Url& url)
+        : arena_(nullptr), data_(nullptr), size_(0)
+    {
+        assign(url);
+    }
+
+    CompactUrl::CompactUrl(const std::string& url)
+        : arena_(nullptr), data_(nullptr), size_(0)
+    {
+        assign(UrlView(url), true);
+    }
+
+    CompactUrl::CompactUrl(const Url& url, Arena& arena)
+        : arena_(&arena), data_(nullptr), size_(0)
+    {
+        assign(url);
+    }
+
+    CompactUrl::CompactUrl(const std::string& url, Arena& arena)
+        : arena_(&arena), data_(nullptr), size_(0)
+    {
+        assign(UrlView(url), true);
+    }
+
+    CompactUrl::CompactUrl(const CompactUrl& other)
+        : arena_(nullptr), data_(nullptr), size_(0)
+    {
+        copy(other);
+    }
+
+    CompactUrl::CompactUrl(CompactUrl&& other)
+        : arena_(other.arena_)
+        , data_(other.data_)
+        , size_(other.size_)
+        , scheme_(other.scheme_)
+        , userinfo_(other.userinfo_)
+        , host_(other.host_)
+        , path_(other.path_)
+        , params_(other.params_)
+        , query_(other.query_)
+        , fragment_(other.fragment_)
+        , flags_(other.flags_)
+        , scheme_id_(other.scheme_id_)
+        , port_(other.port_)
+    {
+        // Leave other as a valid, empty URL
+        Span empty = { 0, 0 };
+        other.data_ = nullptr;
+        other.size_ = 0;
+        other.scheme_ = other.userinfo_ = other.host_ = other.path_ = empty;
+        other.params_ = other.query_ = other.fragment_ = empty;
+        other.flags_ = 0;
+        other.scheme_id_ = Scheme::NONE;
+        other.port_ = 0;
+    }
+
+    CompactUrl& CompactUrl::operator=(const CompactUrl& other)
+    {
+        if (this != &other)
+        {
+            copy(other);
+        }
+        return *this;
+    }
+
+    CompactUrl& CompactUrl::operator=(CompactUrl&& other)
+    {
+        if (arena_ != other.arena_)
+        {
+            // Buffers can only change hands when they come from the same place
+            return operator=(other);
+        }
+
+        std::swap(data_, other.data_);
+        std::swap(size_, other.size_);
+        std::swap(scheme_, other.scheme_);
+        std::swap(userinfo_, other.userinfo_);
+        std::swap(host_, other.host_);
+        std::swap(path_, other.path_);
+        std::swap(params_, other.params_);
+        std::swap(query_, other.query_);
+        std::swap(fragment_, other.fragment_);
+        std::swap(flags_, other.flags_);
+        std::swap(scheme_id_, other.scheme_id_);
+        std::swap(port_, other.port_);
+        return *this;
+    }
+
+    CompactUrl::~CompactUrl()
+    {
+        deallocate();
+    }
+
+    char* CompactUrl::allocate(size_t length)
+    {
+        if (arena_)
+        {
+            return static_cast<char*>(arena_->allocate(length, 1));
+        }
+        return new char[length];
+    }
+
+    void CompactUrl::deallocate()
+    {
+        if (!arena_)
+        {
+            delete[] data_;
+        }
+        data_ = nullptr;
+    }
+
+    void CompactUrl::copy(const CompactUrl& other)
+    {
+        char* data = allocate(other.size_);
+        if (other.size_)
+        {
+            std::memcpy(data, other.data_, other.size_);
+        }
+        deallocate();
+        data_ = data;
+        size_ = other.size_;
+        scheme_ = other.scheme_;
+        userinfo_ = other.userinfo_;
+        host_ = other.host_;
+        path_ = other.path_;
+        params_ = other.params_;
+        query_ = other.query_;
+        fragment_ = other.fragment_;
+        flags_ = other.flags_;
+        scheme_id_ = other.scheme_id_;
+        port_ = other.port_;
+    }
+
+    bool CompactUrl::operator==(const CompactUrl& other) const
+    {
+        return (
+            (scheme()   == other.scheme()  ) &&
+            (userinfo() == other.userinfo()) &&
+            (host()     == other.host()    ) &&
+            (port_      == other.port_     ) &&
+            (path()     == other.path()    ) &&
+            (params()   == other.params()  ) &&
+            (query()    == other.query()   ) &&
+            (fragment() == other.fragment()) &&
+            (flags_     == other.flags_    )
+        );
+    }
+
+    bool CompactUrl::operator!=(const CompactUrl& other) const
+    {
+        return !operator==(other);
+    }
+
+    CompactUrl& CompactUrl::assign(const Url& url)
+    {
+        // A Url's scheme and host are already lowercase
+        return assign(url.view(), false);
+    }
+
+    CompactUrl& CompactUrl::assign(const UrlView& components, bool lowercase)
+    {
+        Layout layout(components);
+        if (layout.size() > std::numeric_limits<uint16_t>::max())
+        {
+            throw std::length_error("URL too long to compact.");
+        }
+
+        char* data = allocate(layout.size());
+        layout.write(data, lowercase);
+
+        auto record = [](size_t offset, const StringView& component) -> Span
+        {
+            return {
+                static_cast<uint16_t>(offset),
+                static_cast<uint16_t>(component.size())
+            };
+        };
+        scheme_ = record(layout.schemeOffset(), components.scheme());
+        userinfo_ = record(layout.userinfoOffset(), components.userinfo());
+        host_ = record(layout.hostOffset(), components.host());
+        path_ = record(layout.pathOffset(), components.path());
+        params_ = record(layout.paramsOffset(), components.params());
+        query_ = record(layout.queryOffset(), components.query());
+        fragment_ = record(layout.fragmentOffset(), components.fragment());
+
+        deallocate();
+        data_ = data;
+        size_ = static_cast<uint16_t>(layout.size());
+        port_ = components.port();
+        scheme_id_ = components.schemeId();
+        flags_ = (components.hasParams() ? HAS_PARAMS : 0)
+            | (components.hasQuery() ? HAS_QUERY : 0);
+        return *this;
+    }
+
+    Url CompactUrl::url() const
+    {
+        Url result;
+        result.scheme_.assign(scheme().data(), scheme().size());
+        result.scheme_id_ = scheme_id_;
+        result.userinfo_.assign(userinfo().data(), userinfo().size());
+        result.host_.assign(host().data(), host().size());
+        result.port_ = port_;
+        result.path_.assign(path().data(), path().size());
+        result.params_.assign(params().data(), params().size());
+        result.query_.assign(query().data(), query().size());
+        result.fragment_.assign(fragment().data(), fragment().size());
+        result.has_params_ = flags_ & HAS_PARAMS;
+        result.has_query_ = flags_ & HAS_QUERY;
+        return result;
+    }
+
+    std::string CompactUrl::fullpath() const
+    {
+        // Everything from the path onward is already laid out as fullpath() would, save
+        // for the leading '/'.
+        std::string result;
+        if (path_.length == 0 || data_[path_.offset] != '/')
+        {
+            result.append(1, '/');
+        }
+        result.append(data_ + path_.offset, size_ - path_.offset);
+        return result;
+    }
+
+    CompactUrl& CompactUrl::setScheme(const std::string& s)
+    {
+        return apply([&s](Url& url) { url.setScheme(s); });
+    }
+
+    CompactUrl& CompactUrl::setHost(const std::string& s)
+    {
+        return apply([&s](Url& url) { url.setHost(s); });
+    }
+
+    CompactUrl& CompactUrl::setPort(int i)
+    {
+        return apply([i](Url& url) { url.setPort(i); });
+    }
+
+    CompactUrl& CompactUrl::setPath(const std::string& s)
+    {
+        return apply([&s](Url& url) { url.setPath(s); });
+    }
+
+    CompactUrl& CompactUrl::setParams(const std::string& s)
+    {
+        return apply([&s](Url& url) { url.setParams(s); });
+    }
+
+    CompactUrl& CompactUrl::setQuery(const std::string& s)
+    {
+        return apply([&s](Url& url) { url.setQuery(s); });
+    }
+
+    CompactUrl& CompactUrl::setFragment(const std::string& s)
+    {
+        return apply([&s](Url& url) { url.setFragment(s); });
+    }
+
+    CompactUrl& CompactUrl::setUserinfo(const std::string& s)
+    {
+        return apply([&s](Url& url) { url.setUserinfo(s); });
+    }
+
+    CompactUrl& CompactUrl::strip()
+    {
+        return apply([](Url& url) { url.strip(); });
+    }
+
+    CompactUrl& CompactUrl::abspath()
+    {
+        return apply([](Url& url) { url.abspath(); });
+    }
+
+    CompactUrl& CompactUrl::relative_to(const std::string& other)
+    {
+        return relative_to(Url(other));
+    }
+
+    CompactUrl& CompactUrl::relative_to(const Url& other)
+    {
+        return apply([&other](Url& url) { url.relative_to(other); });
+    }
+
+    CompactUrl& CompactUrl::escape(bool strict)
+    {
+        return apply([strict](Url& url) { url.escape(strict); });
+    }
+
+    CompactUrl& CompactUrl::unescape()
+    {
+        return apply([](Url& url) { url.unescape(); });
+    }
+
+    CompactUrl& CompactUrl::deparam(const std::unordered_set<std::string>& blacklist)
+    {
+        return apply([&blacklist](Url& url) { url.deparam(blacklist); });
+    }
+
+    CompactUrl& CompactUrl::deparam(const DeparamFilter& filter)
+    {
+        return apply([&filter](Url& url) { url.deparam(filter); });
+    }
+
+    CompactUrl& CompactUrl::deparam(const Url::deparam_predicate& predicate)
+    {
+        return apply([&predicate](Url& url) { url.deparam(predicate); });
+    }
+
+    CompactUrl& CompactUrl::sort_query()
+    {
+        return apply([](Url& url) { url.sort_query(); });
+    }
+
+    CompactUrl& CompactUrl::remove_default_port()
+    {
+        return apply([](Url& url) { url.remove_default_port(); });
+    }
+
+    CompactUrl& CompactUrl::deuserinfo()
+    {
+        return apply([](Url& url) { url.deuserinfo(); });
+    }
+
+    CompactUrl& CompactUrl::defrag()
+    {
+        return apply([](Url& url) { url.defrag(); });
+    }
+
+    CompactUrl& CompactUrl::punycode()
+    {
+        return apply([](Url& url) { url.punycode(); });
+    }
+
+    CompactUrl& CompactUrl::unpunycode()
+    {
+        return apply([](Url& url) { url.unpunycode(); });
+    }
+
+    CompactUrl& CompactUrl::host_reversed()
+    {
+        return apply([](Url& url) { url.host_reversed(); });
+    }
+
+};
@@ -0,0 +1,92 @@
+#include <algorithm>
+
+#include "deparam.h"
+
+namespace
+{
+    inline char lower(char c)
+    {
+        return (c >= 'A' && c <= 'Z') ? (c | 0x20) : c;
+    }
+}
+
+namespace Url
+{
+
+    DeparamFilter::DeparamFilter(const std::unordered_set<std::string>& blacklist)
+        : names_(), slots_(), mask_(0), size_(0)
+    {
+        // Keep the table at most half full
+        size_t capacity = 8;
+        while (capacity < 2 * blacklist.size())
+        {
+            capacity *= 2;
+        }
+        Slot empty = { 0, EMPTY, 0 };
+        slots_.assign(capacity, empty);
+        mask_ = capacity - 1;
+
+        for (auto it = blacklist.begin(); it != blacklist.end(); ++it)
+        {
+            // Names with uppercase characters would never have matched a lowercased name
+            if (std::find_if(it->begin(), it->end(), [](char c) {
+                    return c >= 'A' && c <= 'Z'; }) != it->end())
+            {
+                continue;
+            }
+
+            uint64_t hashed = hash(it->data(), it->size());
+            size_t index = hashed & mask_;
+            while (slots_[index].offset != EMPTY)
+            {
+                index = (index + 1) & mask_;
+            }
+
+            slots_[index].hash = hashed;
+            slots_[index].offset = static_cast<uint32_t>(names_.size());
+            slots_[index].length = static_cast<uint32_t>(it->size());
+            names_.append(*it);
+            ++size_;
+        }
+    }
+
+    bool DeparamFilter::contains(const char* name, size_t length) const
+    {
+        uint64_t hashed = hash(name, length);
+        for (size_t index = hashed & mask_
+            ; slots_[index].offset != EMPTY
+            ; index = (index + 1) & mask_)
+        {
+            const Slot& slot = slots_[index];
+            if (slot.hash != hashed || slot.length != length)
+            {
+                continue;
+            }
+
+            const char* candidate = names_.data() + slot.offset;
+            size_t position = 0;
+            while (position < length && lower(name[position]) == candidate[position])
+            {
+                ++position;
+            }
+            if (position == length)
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    uint64_t DeparamFilter::hash(const char* data, size_t length)
+    {
+        // 64-bit FNV-1a
+        uint64_t result = 0xCBF29CE484222325ULL;
+        for (size_t index = 0; index < length; ++index)
+        {
+            result ^= static_cast<unsigned char>(lower(data[index]));
+            result *= 0x100000001B3ULL;
+        }
+        return result;
+    }
+
+};
@@ -0,0 +1,162 @@
+#include <cstring>
+
+#include "hash.h"
+
+namespace
+{
+    const uint64_t PRIME_1 = 0x9E3779B185EBCA87ULL;
+    const uint64_t PRIME_2 = 0xC2B2AE3D27D4EB4FULL;
+    const uint64_t PRIME_3 = 0x165667B19E3779F9ULL;
+    const uint64_t PRIME_4 = 0x85EBCA77C2B2AE63ULL;
+    const uint64_t PRIME_5 = 0x27D4EB2F165667C5ULL;
+
+    uint64_t rotate(uint64_t value, int bits)
+    {
+        return (value << bits) | (value >> (64 - bits));
+    }
+
+    // Reads are little-endian, whatever the platform
+    uint64_t read64(const char* data)
+    {
+        uint64_t value;
+        std::memcpy(&value, data, sizeof(value));
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+        value = __builtin_bswap64(value);
+#endif
+        return value;
+    }
+
+    uint32_t read32(const char* data)
+    {
+        uint32_t value;
+        std::memcpy(&value, data, sizeof(value));
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+        value = __builtin_bswap32(value);
+#endif
+        return value;
+    }
+
+    uint64_t round(uint64_t lane, uint64_t input)
+    {
+        return rotate(lane + input * PRIME_2, 31) * PRIME_1;
+    }
+
+    uint64_t merge(uint64_t hash, uint64_t lane)
+    {
+        return (hash ^ round(0, lane)) * PRIME_1 + PRIME_4;
+    }
+
+    // Consume one 32-byte stripe into the four lanes
+    void stripe(uint64_t* lanes, const char* data)
+    {
+        lanes[0] = round(lanes[0], read64(data));
+        lanes[1] = round(lanes[1], read64(data + 8));
+        lanes[2] = round(lanes[2], read64(data + 16));
+        lanes[3] = round(lanes[3], read64(data + 24));
+    }
+}
+
+namespace Url
+{
+
+    Hasher::Hasher(uint64_t seed): seed_(seed), length_(0), buffered_(0)
+    {
+        lanes_[0] = seed + PRIME_1 + PRIME_2;
+        lanes_[1] = seed + PRIME_2;
+        lanes_[2] = seed;
+        lanes_[3] = seed - PRIME_1;
+    }
+
+    uint64_t Hasher::hash(const char* data, size_t length, uint64_t seed)
+    {
+        return Hasher(seed).update(data, length).digest();
+    }
+
+    Hasher& Hasher::update(const char* data, size_t length)
+    {
+        length_ += length;
+
+        if (buffered_ + length < sizeof(buffer_))
+        {
+            if (length)
+            {
+                std::memcpy(buffer_ + buffered_, data, length);
+                buffered_ += length;
+            }
+            return *this;
+        }
+
+        const char* end = data + length;
+        if (buffered_)
+        {
+            // Complete the partial stripe first
+            size_t fill = sizeof(buffer_) - buffered_;
+            std::memcpy(buffer_ + buffered_, data, fill);
+            stripe(lanes_, buffer_);
+            data += fill;
+            buffered_ = 0;
+        }
+
+        for (; static_cast<size_t>(end - data) >= sizeof(buffer_); data += sizeof(buffer_))
+        {
+            stripe(lanes_, data);
+        }
+
+        buffered_ = end - data;
+        if (buffered_)
+        {
+            std::memcpy(buffer_, data, buffered_);
+        }
+        return *this;
+    }
+
+    uint64_t Hasher::digest() const
+    {
+        uint64_t hash;
+        if (length_ >= sizeof(buffer_))
+        {
+            hash = rotate(lanes_[0], 1) + rotate(lanes_[1], 7)
+                + rotate(lanes_[2], 12) + rotate(lanes_[3], 18);
+            hash = merge(hash, lanes_[0]);
+            hash = merge(hash, lanes_[1]);
+            hash = merge(hash, lanes_[2]);
+            hash = merge(hash, lanes_[3]);
+        }
+        else
+        {
+            hash = seed_ + PRIME_5;
+        }
+        hash += length_;
+
+        // Whatever is left over in the buffer, 8, then 4, then 1 byte at a time
+        const char* data = buffer_;
+        const char* end = buffer_ + buffered_;
+        for (; end - data >= 8; data += 8)
+        {
+            hash ^= round(0, read64(data));
+            hash = rotate(hash, 27) * PRIME_1 + PRIME_4;
+        }
+
+        if (end - data >= 4)
+        {
+            hash ^= static_cast<uint64_t>(read32(data)) * PRIME_1;
+            hash = rotate(hash, 23) * PRIME_2 + PRIME_3;
+            data += 4;
+        }
+
+        for (; data != end; ++data)
+        {
+            hash ^= static_cast<unsigned char>(*data) * PRIME_5;
+            hash = rotate(hash, 11) * PRIME_1;
+        }
+
+        // Avalanche
+        hash ^= hash >> 33;
+        hash *= PRIME_2;
+        hash ^= hash >> 29;
+        hash *= PRIME_3;
+        hash ^= hash >> 32;
+        return hash;
+    }
+
+};
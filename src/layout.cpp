@@ -0,0 +1,96 @@
+#include <cstring>
+
+#include "layout.h"
+
+namespace Url
+{
+
+    Layout::Layout(const UrlView& url)
+        : url_(url), separator_(""), separatorLength_(0), portLength_(0)
+    {
+        if (!url.scheme().empty())
+        {
+            separator_ = (Schemes::flags(url.schemeId()) & Schemes::USES_NETLOC)
+                ? "://" : ":";
+        }
+        else if (!url.host().empty())
+        {
+            separator_ = "//";
+        }
+        separatorLength_ = std::strlen(separator_);
+
+        if (url.port())
+        {
+            // Written backwards from the end of the buffer, and then moved to the front
+            unsigned int value = static_cast<unsigned int>(url.port());
+            if (url.port() < 0)
+            {
+                value = 0u - value;
+            }
+
+            char* end = port_ + sizeof(port_);
+            char* it = end;
+            do
+            {
+                *--it = static_cast<char>('0' + (value % 10));
+                value /= 10;
+            } while (value);
+
+            if (url.port() < 0)
+            {
+                *--it = '-';
+            }
+            portLength_ = end - it;
+            std::memmove(port_, it, portLength_);
+        }
+
+        size_t size = 0;
+        scheme_ = size;
+        size += url.scheme().size() + separatorLength_;
+
+        userinfo_ = size;
+        size += url.userinfo().empty() ? 0 : url.userinfo().size() + 1;
+
+        host_ = size;
+        size += url.host().size();
+        size += portLength_ ? portLength_ + 1 : 0;
+
+        slash_ = url.path().empty()
+            ? size > 0
+            : (!url.host().empty() && url.path()[0] != '/');
+        size += slash_ ? 1 : 0;
+
+        path_ = size;
+        size += url.path().size();
+
+        size += url.hasParams() ? 1 : 0;
+        params_ = size;
+        size += url.params().size();
+
+        size += url.hasQuery() ? 1 : 0;
+        query_ = size;
+        size += url.query().size();
+
+        size += url.fragment().empty() ? 0 : 1;
+        fragment_ = size;
+        size += url.fragment().size();
+
+        size_ = size;
+    }
+
+    char* Layout::write(char* out, bool lowercase) const
+    {
+        auto append = [&out](const char* data, size_t size)
+        {
+            // Empty components may have no data at all
+            if (size)
+            {
+                std::memcpy(out, data, size);
+                out += size;
+            }
+        };
+        emit(append, lowercase);
+        return out;
+    }
+
+};
@@ -8,7 +8,83 @@
 namespace Url
 {
 
+    const int8_t Punycode::BASIC_TO_DIGIT[256] = {
+        -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+        -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+
+        -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+        26, 27, 28, 29, 30, 31, 32, 33, 34, 35, -1, -1, -1, -1, -1, -1,
+
+        -1,  0,  1,  2,  3,  4,  5,  6,  7,  8,  9, 10, 11, 12, 13, 14,
+        15, 16, 17, 18, 19, 20, 21, 22, 23, 24, 25, -1, -1, -1, -1, -1,
+
+        -1,  0,  1,  2,  3,  4,  5,  6,  7,  8,  9, 10, 11, 12, 13, 14,
+        15, 16, 17, 18, 19, 20, 21, 22, 23, 24, 25, -1, -1, -1, -1, -1,
+
+        -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+        -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+
+        -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+        -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+
+        -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+        -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+
+        -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+        -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1
+    };
+
+    const char* Punycode::message(Punycode::Status status)
+    {
+        switch (status)
+        {
+            case Status::OK:
+                return "OK";
+            case Status::INVALID_UTF8:
+                return "Invalid UTF-8.";
+            case Status::OVERFLOW_DELTA_UPDATE:
+                return "Overflow delta update.";
+            case Status::OVERFLOW_DELTA_INCREMENT:
+                return "Overflow delta increment.";
+            case Status::NON_BASIC_CODEPOINT:
+                return "Argument has non-basic code points.";
+            case Status::PREMATURE_TERMINATION:
+                return "Premature termination";
+            case Status::INVALID_DIGIT:
+                return "Invalid base 36 character.";
+            case Status::OVERFLOW_I:
+                return "Overflow on i.";
+            case Status::OVERFLOW_W:
+                return "Overflow on w.";
+            case Status::OVERFLOW_N:
+                return "Overflow on n.";
+            case Status::CODEPOINT_TOO_HIGH:
+                return "Code point too high.";
+        }
+        return "Unknown punycode status"; // LCOV_EXCL_LINE
+    }
+
     std::string& Punycode::encode(std::string& str)
+    {
+        std::string output;
+        Status status = encode(str, output);
+        if (status == Status::INVALID_UTF8)
+        {
+            // Read the input again to throw with the specific UTF-8 error
+            for (auto it = str.cbegin(); it != str.cend(); )
+            {
+                Utf8::readCodepoint(it, str.cend());
+            }
+        }
+        if (status != Status::OK)
+        {
+            throw std::invalid_argument(message(status));
+        }
+        str.swap(output);
+        return str;
+    }
+
+    Punycode::Status Punycode::encode(const std::string& str, std::string& output)
     {
         // Pseudocode copied from https://tools.ietf.org/html/rfc3492#section-6.3
         //
@@ -18,13 +94,18 @@ namespace Url
         punycode_uint n = INITIAL_N;
         punycode_uint delta = 0;
         punycode_uint bias = INITIAL_BIAS;
-        std::string output;
+        output.clear();
 
         // Accumulate the non-basic codepoints
         std::vector<punycode_uint> codepoints;
         for (auto it = str.cbegin(); it != str.cend(); )
         {
-            Utf8::codepoint_t value = Utf8::readCodepoint(it, str.cend());
+            Utf8::codepoint_t value = 0;
+            if (Utf8::readCodepoint(it, str.cend(), value) != Utf8::Status::OK)
+            {
+                return Status::INVALID_UTF8;
+            }
+
             if (value < 0x80)
             {
                 // copy them to the output in order
@@ -59,7 +140,7 @@ namespace Url
             // let delta = delta + (m - n) * (h + 1), fail on overflow
             if ((m - n) > ((MAX_PUNYCODE_UINT - delta) / (h + 1)))
             {
-                throw std::invalid_argument("Overflow delta update.");
+                return Status::OVERFLOW_DELTA_UPDATE;
             }
             delta += (m - n) * (h + 1);
 
@@ -74,7 +155,7 @@ namespace Url
                 {
                     if (delta == MAX_PUNYCODE_UINT)
                     {
-                        throw std::invalid_argument("Overflow delta increment.");
+                        return Status::OVERFLOW_DELTA_INCREMENT;
                     }
                     ++delta;
                 }
@@ -125,8 +206,7 @@ namespace Url
             ++n;
         }
 
-        str.assign(output);
-        return str;
+        return Status::OK;
     }
 
     std::string Punycode::encode(const std::string& str)
@@ -177,6 +257,18 @@ namespace Url
     }
 
     std::string& Punycode::decode(std::string& str)
+    {
+        std::string output;
+        Status status = decode(str, output);
+        if (status != Status::OK)
+        {
+            throw std::invalid_argument(message(status));
+        }
+        str.swap(output);
+        return str;
+    }
+
+    Punycode::Status Punycode::decode(const std::string& str, std::string& output)
     {
         // Pseudocode copied from https://tools.ietf.org/html/rfc3492#section-6.2
         //
@@ -201,7 +293,7 @@ namespace Url
         {
             if (static_cast<unsigned char>(*it) > 127U)
             {
-                throw std::invalid_argument("Argument has non-basic code points.");
+                return Status::NON_BASIC_CODEPOINT;
             }
             codepoints.push_back(*it);
         }
@@ -227,21 +319,21 @@ namespace Url
                 // consume a code point, or fail if there was none to consume
                 if (it == str.end())
                 {
-                    throw std::invalid_argument("Premature termination");
+                    return Status::PREMATURE_TERMINATION;
                 }
 
                 // let digit = the code point's digit-value, fail if it has none
-                int lookup = BASIC_TO_DIGIT[static_cast<size_t>(*it)];
+                int lookup = BASIC_TO_DIGIT[static_cast<unsigned char>(*it)];
                 if (lookup == -1)
                 {
-                    throw std::invalid_argument("Invalid base 36 character.");
+                    return Status::INVALID_DIGIT;
                 }
                 unsigned char digit = static_cast<unsigned char>(lookup);
 
                 // let i = i + digit * w, fail on overflow
                 if (digit > ((MAX_PUNYCODE_UINT - i) / w))
                 {
-                    throw std::invalid_argument("Overflow on i.");
+                    return Status::OVERFLOW_I;
                 }
                 i += digit * w;
 
@@ -289,7 +381,7 @@ namespace Url
                     //
                     // However, the next iteration now overflows i before we can get to
                     // the w update.
-                    throw std::invalid_argument("Overflow on w."); // LCOV_EXCL_LINE
+                    return Status::OVERFLOW_W; // LCOV_EXCL_LINE
                 }
                 w *= (BASE - t);
             }
@@ -300,7 +392,7 @@ namespace Url
             // let n = n + i div (length(output) + 1), fail on overflow
             if ((i / (codepoints.size() + 1)) > (MAX_PUNYCODE_UINT - n))
             {
-                throw std::invalid_argument("Overflow on n.");
+                return Status::OVERFLOW_N;
             }
             n += i / (codepoints.size() + 1);
 
@@ -314,14 +406,17 @@ namespace Url
             ++i;
         }
 
-        std::string output;
+        output.clear();
         for (auto it = codepoints.begin(); it != codepoints.end(); ++it)
         {
+            if (*it > Utf8::MAX_CODEPOINT)
+            {
+                return Status::CODEPOINT_TOO_HIGH;
+            }
             Utf8::writeCodepoint(output, *it);
         }
-        str.assign(output);
 
-        return str;
+        return Status::OK;
     }
 
     std::string Punycode::decode(const std::string& str)
@@ -0,0 +1,101 @@
+#include <cstring>
+
+#include "query.h"
+
+namespace Url
+{
+
+    QueryView::iterator::iterator(const char* position, const char* end, char sep)
+        : position_(position), next_(position), end_(end), sep_(sep), param_()
+    {
+        load();
+    }
+
+    QueryView::iterator& QueryView::iterator::operator++()
+    {
+        position_ = (next_ == end_) ? end_ : next_ + 1;
+        load();
+        return *this;
+    }
+
+    QueryView::iterator QueryView::iterator::operator++(int)
+    {
+        iterator result(*this);
+        ++(*this);
+        return result;
+    }
+
+    void QueryView::iterator::load()
+    {
+        while (position_ != end_ && *position_ == sep_)
+        {
+            ++position_;
+        }
+        if (position_ == end_)
+        {
+            return;
+        }
+
+        const char* found = static_cast<const char*>(
+            std::memchr(position_, sep_, end_ - position_));
+        next_ = found ? found : end_;
+
+        const char* equals = static_cast<const char*>(
+            std::memchr(position_, '=', next_ - position_));
+        if (equals)
+        {
+            param_.key = StringView(position_, equals - position_);
+            param_.value = StringView(equals + 1, next_ - equals - 1);
+        }
+        else
+        {
+            param_.key = StringView(position_, next_ - position_);
+            param_.value = StringView(next_, 0);
+        }
+    }
+
+    QueryView::iterator QueryView::begin() const
+    {
+        return iterator(str_.begin(), str_.end(), sep_);
+    }
+
+    QueryView::iterator QueryView::end() const
+    {
+        return iterator(str_.end(), str_.end(), sep_);
+    }
+
+    size_t QueryView::count() const
+    {
+        size_t result = 0;
+        for (iterator it = begin(); it != end(); ++it)
+        {
+            ++result;
+        }
+        return result;
+    }
+
+    bool QueryView::has(const StringView& key) const
+    {
+        for (iterator it = begin(); it != end(); ++it)
+        {
+            if (it->key == key)
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    StringView QueryView::get(const StringView& key) const
+    {
+        for (iterator it = begin(); it != end(); ++it)
+        {
+            if (it->key == key)
+            {
+                return it->value;
+            }
+        }
+        return StringView();
+    }
+
+};
@@ -0,0 +1,87 @@
+#include "scan.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define URL_SCAN_SSSE3
+#include <immintrin.h>
+#endif
+
+namespace Url
+{
+
+    Scan::mask_t Scan::delimitersScalar(const char* block, size_t length)
+    {
+        mask_t mask = 0;
+        for (size_t index = 0; index < length; ++index)
+        {
+            if (isDelimiter(block[index]))
+            {
+                mask |= (static_cast<mask_t>(1) << index);
+            }
+        }
+        return mask;
+    }
+
+    namespace
+    {
+#if defined(URL_SCAN_SSSE3)
+        /**
+         * Scan::plain for full 16-byte blocks, stopping at the first block with a byte
+         * that isn't plain. Only ASCII sets may be provided.
+         */
+        __attribute__((target("ssse3")))
+        size_t plainSsse3(const char* data, size_t length, const CharacterClass& safe)
+        {
+            const __m128i nibbles = _mm_loadu_si128(
+                reinterpret_cast<const __m128i*>(safe.nibbles()));
+            // The bit for each high nibble, with none for non-ASCII bytes
+            const __m128i bits = _mm_setr_epi8(
+                1, 2, 4, 8, 16, 32, 64, -128, 0, 0, 0, 0, 0, 0, 0, 0);
+            const __m128i low = _mm_set1_epi8(0x0F);
+            const __m128i percent = _mm_set1_epi8('%');
+
+            size_t index = 0;
+            for (; length - index >= 16; index += 16)
+            {
+                __m128i bytes = _mm_loadu_si128(
+                    reinterpret_cast<const __m128i*>(data + index));
+                __m128i row = _mm_shuffle_epi8(nibbles, _mm_and_si128(bytes, low));
+                __m128i bit = _mm_shuffle_epi8(
+                    bits, _mm_and_si128(_mm_srli_epi16(bytes, 4), low));
+                __m128i stops = _mm_or_si128(
+                    _mm_cmpeq_epi8(_mm_and_si128(row, bit), _mm_setzero_si128()),
+                    _mm_cmpeq_epi8(bytes, percent));
+                int mask = _mm_movemask_epi8(stops);
+                if (mask)
+                {
+                    return index + __builtin_ctz(mask);
+                }
+            }
+            return index;
+        }
+#endif
+    }
+
+    size_t Scan::plain(const char* data, size_t length, const CharacterClass& safe)
+    {
+        size_t index = 0;
+#if defined(URL_SCAN_SSSE3)
+        static const bool ssse3 = __builtin_cpu_supports("ssse3");
+        if (ssse3 && length >= 16 && safe.ascii())
+        {
+            index = plainSsse3(data, length, safe);
+        }
+#endif
+        return index + plainScalar(data + index, length - index, safe);
+    }
+
+    size_t Scan::plainScalar(const char* data, size_t length, const CharacterClass& safe)
+    {
+        size_t index = 0;
+        while (index < length && data[index] != '%' && safe(data[index]))
+        {
+            ++index;
+        }
+        return index;
+    }
+
+};
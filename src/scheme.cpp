@@ -0,0 +1,162 @@
+#include <cstring>
+
+#include "scheme.h"
+
+namespace
+{
+    /**
+     * Pack up to the first 8 characters of a string into an integer, first character in
+     * the lowest byte. This is used for the case labels of lookup.
+     */
+    constexpr uint64_t pack(const char* str, size_t index = 0)
+    {
+        return (index == 8 || !str[index]) ? 0 :
+            (static_cast<uint64_t>(static_cast<unsigned char>(str[index])) << (8 * index))
+            | pack(str, index + 1);
+    }
+}
+
+namespace Url
+{
+
+    const uint8_t Schemes::FLAGS[] = {
+        /* NONE     */ USES_RELATIVE | USES_NETLOC | USES_PARAMS | KNOWN,
+        /* FILE     */ USES_RELATIVE | USES_NETLOC | KNOWN,
+        /* FTP      */ USES_RELATIVE | USES_NETLOC | USES_PARAMS | KNOWN,
+        /* GIT      */ USES_NETLOC | KNOWN,
+        /* GIT_SSH  */ USES_NETLOC | KNOWN,
+        /* GOPHER   */ USES_RELATIVE | USES_NETLOC | KNOWN,
+        /* HDL      */ USES_PARAMS | KNOWN,
+        /* HTTP     */ USES_RELATIVE | USES_NETLOC | USES_PARAMS | KNOWN,
+        /* HTTPS    */ USES_RELATIVE | USES_NETLOC | USES_PARAMS | KNOWN,
+        /* IMAP     */ USES_RELATIVE | USES_NETLOC | USES_PARAMS | KNOWN,
+        /* MMS      */ USES_RELATIVE | USES_NETLOC | USES_PARAMS | KNOWN,
+        /* NFS      */ USES_NETLOC | KNOWN,
+        /* NNTP     */ USES_RELATIVE | USES_NETLOC | KNOWN,
+        /* PROSPERO */ USES_RELATIVE | USES_NETLOC | USES_PARAMS | KNOWN,
+        /* RSYNC    */ USES_NETLOC | KNOWN,
+        /* RTSP     */ USES_RELATIVE | USES_NETLOC | USES_PARAMS | KNOWN,
+        /* RTSPU    */ USES_RELATIVE | USES_NETLOC | USES_PARAMS | KNOWN,
+        /* SFTP     */ USES_RELATIVE | USES_NETLOC | USES_PARAMS | KNOWN,
+        /* SHTTP    */ USES_RELATIVE | USES_NETLOC | USES_PARAMS | KNOWN,
+        /* SIP      */ USES_PARAMS | KNOWN,
+        /* SIPS     */ USES_PARAMS | KNOWN,
+        /* SMS      */ KNOWN,
+        /* SNEWS    */ USES_NETLOC | KNOWN,
+        /* SVN      */ USES_RELATIVE | USES_NETLOC | KNOWN,
+        /* SVN_SSH  */ USES_RELATIVE | USES_NETLOC | KNOWN,
+        /* TEL      */ USES_PARAMS | KNOWN,
+        /* TELNET   */ USES_NETLOC | KNOWN,
+        /* WAIS     */ USES_RELATIVE | USES_NETLOC | KNOWN,
+        /* UNKNOWN  */ 0
+    };
+
+    const char* const Schemes::NAMES[] = {
+        "",
+        "file",
+        "ftp",
+        "git",
+        "git+ssh",
+        "gopher",
+        "hdl",
+        "http",
+        "https",
+        "imap",
+        "mms",
+        "nfs",
+        "nntp",
+        "prospero",
+        "rsync",
+        "rtsp",
+        "rtspu",
+        "sftp",
+        "shttp",
+        "sip",
+        "sips",
+        "sms",
+        "snews",
+        "svn",
+        "svn+ssh",
+        "tel",
+        "telnet",
+        "wais",
+        ""
+    };
+
+    Scheme Schemes::classify(const char* data, size_t length)
+    {
+        if (length > 8)
+        {
+            return Scheme::UNKNOWN;
+        }
+
+        uint64_t packed = 0;
+        for (size_t index = 0; index < length; ++index)
+        {
+            packed |= static_cast<uint64_t>(static_cast<unsigned char>(data[index]))
+                << (8 * index);
+        }
+        return lookup(packed, length);
+    }
+
+    Scheme Schemes::classifyInsensitive(const char* data, size_t length)
+    {
+        if (length > 8)
+        {
+            return Scheme::UNKNOWN;
+        }
+
+        uint64_t packed = 0;
+        for (size_t index = 0; index < length; ++index)
+        {
+            unsigned char c = static_cast<unsigned char>(data[index]);
+            if (c >= 'A' && c <= 'Z')
+            {
+                c |= 0x20;
+            }
+            packed |= static_cast<uint64_t>(c) << (8 * index);
+        }
+        return lookup(packed, length);
+    }
+
+    Scheme Schemes::lookup(uint64_t packed, size_t length)
+    {
+        Scheme result;
+        switch (packed)
+        {
+            case pack(""):         result = Scheme::NONE;     break;
+            case pack("file"):     result = Scheme::FILE;     break;
+            case pack("ftp"):      result = Scheme::FTP;      break;
+            case pack("git"):      result = Scheme::GIT;      break;
+            case pack("git+ssh"):  result = Scheme::GIT_SSH;  break;
+            case pack("gopher"):   result = Scheme::GOPHER;   break;
+            case pack("hdl"):      result = Scheme::HDL;      break;
+            case pack("http"):     result = Scheme::HTTP;     break;
+            case pack("https"):    result = Scheme::HTTPS;    break;
+            case pack("imap"):     result = Scheme::IMAP;     break;
+            case pack("mms"):      result = Scheme::MMS;      break;
+            case pack("nfs"):      result = Scheme::NFS;      break;
+            case pack("nntp"):     result = Scheme::NNTP;     break;
+            case pack("prospero"): result = Scheme::PROSPERO; break;
+            case pack("rsync"):    result = Scheme::RSYNC;    break;
+            case pack("rtsp"):     result = Scheme::RTSP;     break;
+            case pack("rtspu"):    result = Scheme::RTSPU;    break;
+            case pack("sftp"):     result = Scheme::SFTP;     break;
+            case pack("shttp"):    result = Scheme::SHTTP;    break;
+            case pack("sip"):      result = Scheme::SIP;      break;
+            case pack("sips"):     result = Scheme::SIPS;     break;
+            case pack("sms"):      result = Scheme::SMS;      break;
+            case pack("snews"):    result = Scheme::SNEWS;    break;
+            case pack("svn"):      result = Scheme::SVN;      break;
+            case pack("svn+ssh"):  result = Scheme::SVN_SSH;  break;
+            case pack("tel"):      result = Scheme::TEL;      break;
+            case pack("telnet"):   result = Scheme::TELNET;   break;
+            case pack("wais"):     result = Scheme::WAIS;     break;
+            default:               return Scheme::UNKNOWN;
+        }
+
+        // Embedded NUL bytes pack the same as a shorter scheme
+        return (std::strlen(name(result)) == length) ? result : Scheme::UNKNOWN;
+    }
+
+};
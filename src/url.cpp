@@ -1,42 +1,53 @@
 #include <algorithm>
+#include <cstring>
+#include <limits>
 #include <string>
 #include <iterator>
 #include <unordered_map>
 #include <unordered_set>
 #include <iostream>
 #include <iterator>
-#include <sstream>
 
 #include "url.h"
+#include "deparam.h"
+#include "hash.h"
+#include "layout.h"
 #include "punycode.h"
+#include "scan.h"
 
 namespace Url
 {
 
     /* Character classes */
-    const CharacterClass Url::GEN_DELIMS(":/?#[]@");
-    const CharacterClass Url::SUB_DELIMS("!$&'()*+,;=");
-    const CharacterClass Url::DIGIT("0123456789");
-    const CharacterClass Url::ALPHA(
-        "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz");
-    const CharacterClass Url::UNRESERVED(
-        Url::ALPHA.chars() + Url::DIGIT.chars() + "-._~");
-    const CharacterClass Url::RESERVED(
-        Url::GEN_DELIMS.chars() + Url::SUB_DELIMS.chars());
-    const CharacterClass Url::PCHAR(
-        Url::UNRESERVED.chars() + Url::SUB_DELIMS.chars() + ":@");
-    const CharacterClass Url::PATH(
-        Url::PCHAR.chars() + "/");
-    const CharacterClass Url::QUERY(
-        Url::PCHAR.chars() + "/?");
-    const CharacterClass Url::FRAGMENT(
-        Url::PCHAR.chars() + "/?");
-    const CharacterClass Url::USERINFO(
-        Url::UNRESERVED.chars() + Url::SUB_DELIMS.chars() + ":");
+#define URL_GEN_DELIMS ":/?#[]@"
+#define URL_SUB_DELIMS "!$&'()*+,;="
+#define URL_DIGIT "0123456789"
+#define URL_ALPHA "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz"
+#define URL_UNRESERVED URL_ALPHA URL_DIGIT "-._~"
+#define URL_PCHAR URL_UNRESERVED URL_SUB_DELIMS ":@"
+    const CharacterClass Url::GEN_DELIMS(URL_GEN_DELIMS);
+    const CharacterClass Url::SUB_DELIMS(URL_SUB_DELIMS);
+    const CharacterClass Url::DIGIT(URL_DIGIT);
+    const CharacterClass Url::ALPHA(URL_ALPHA);
+    const CharacterClass Url::UNRESERVED(URL_UNRESERVED);
+    const CharacterClass Url::RESERVED(URL_GEN_DELIMS URL_SUB_DELIMS);
+    const CharacterClass Url::PCHAR(URL_PCHAR);
+    const CharacterClass Url::PATH(URL_PCHAR "/");
+    const CharacterClass Url::QUERY(URL_PCHAR "/?");
+    const CharacterClass Url::FRAGMENT(URL_PCHAR "/?");
+    const CharacterClass Url::USERINFO(URL_UNRESERVED URL_SUB_DELIMS ":");
     const CharacterClass Url::HEX("0123456789ABCDEF");
     const CharacterClass Url::SCHEME(
         "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789+-.");
-    const std::vector<signed char> Url::HEX_TO_DEC = {
+#undef URL_PCHAR
+#undef URL_UNRESERVED
+#undef URL_ALPHA
+#undef URL_DIGIT
+#undef URL_SUB_DELIMS
+#undef URL_GEN_DELIMS
+
+    // Indexed by unsigned char
+    const signed char Url::HEX_TO_DEC[256] = {
         -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
         -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
 
@@ -157,152 +168,979 @@ namespace Url
         "wais"
     };
 
-    Url::Url(const std::string& url): port_(0), has_params_(false), has_query_(false)
+    namespace
     {
-        size_t position = 0;
-        size_t index = url.find(':');
-        if (index != std::string::npos)
+        /**
+         * Room for some number of elements, kept in place unless more than N are needed.
+         */
+        template<typename T, size_t N>
+        struct ScratchArray
         {
-            // All the characters in our would-be scheme must be in SCHEME
-            if (std::all_of(
-                    url.begin(),
-                    url.begin() + index,
-                    [](char c) { return SCHEME(c); } ))
+            T* get(size_t count)
             {
-                // If there is nothing after the : or there are any non-digits, this is
-                // the scheme
-                if ((index + 1) >= url.length()
-                    || std::any_of(
-                        url.begin() + index + 1,
-                        url.end(),
-                        [](char c) { return !DIGIT(c); }))
+                if (count <= N)
                 {
-                    scheme_.assign(url, 0, index);
-                    std::transform(
-                        scheme_.begin(), scheme_.end(), scheme_.begin(), ::tolower);
-                    position = index + 1;
+                    return local_;
                 }
-                else
+                heap_.resize(count);
+                return heap_.data();
+            }
+
+        private:
+            T local_[N];
+            std::vector<T> heap_;
+        };
+
+        /**
+         * Write the escaping of [begin, end) to out, returning the new end of out. See
+         * Url::escape for the rules. The output may be up to three times as long. If
+         * no byte is expanded, out may be begin.
+         */
+        char* escape_to(const char* begin, const char* end, char* out,
+            const CharacterClass& safe, bool strict)
+        {
+            for (const char* src = begin; src < end; ++src)
+            {
+                // Runs of bytes that stay the same are copied in bulk
+                size_t run = Scan::plain(src, end - src, safe);
+                if (run)
                 {
-                    scheme_.assign(url, 0, index);
-                    std::transform(
-                        scheme_.begin(), scheme_.end(), scheme_.begin(), ::tolower);
-                    if (KNOWN_PROTOCOLS.find(scheme_) != KNOWN_PROTOCOLS.end())
+                    if (out != src)
                     {
-                        position = index + 1;
+                        std::memmove(out, src, run);
                     }
-                    else
+                    out += run;
+                    src += run;
+                    if (src == end)
                     {
-                        scheme_.clear();
+                        break;
+                    }
+                }
+
+                char c = *src;
+                // A valid escape needs both of its digits to be within the input
+                if (c == '%' && (end - src) > 2)
+                {
+                    signed char high = Url::HEX_TO_DEC[static_cast<unsigned char>(src[1])];
+                    signed char low = Url::HEX_TO_DEC[static_cast<unsigned char>(src[2])];
+                    if (high != -1 && low != -1)
+                    {
+                        char value = static_cast<char>(high * 16 + low);
+                        if (strict && !(safe(value) && !Url::RESERVED(value)))
+                        {
+                            *out++ = '%';
+                            *out++ = ::toupper(src[1]);
+                            *out++ = ::toupper(src[2]);
+                            src += 2;
+                            continue;
+                        }
+                        src += 2;
+                        c = value;
                     }
                 }
+
+                if (!safe(c))
+                {
+                    *out++ = '%';
+                    *out++ = Url::HEX.chars()[(c >> 4) & 0xF];
+                    *out++ = Url::HEX.chars()[c & 0xF];
+                }
+                else
+                {
+                    *out++ = c;
+                }
             }
+            return out;
         }
 
-        // Search for the netloc
-        if ((url.length() - position) >= 1
-            && url[position] == '/'
-            && url[position + 1] == '/')
+        /**
+         * Write the unescaping of [begin, end) to out, returning the new end of out. See
+         * Url::unescape for the rules. The output is never longer, so out may be begin.
+         */
+        char* unescape_to(const char* begin, const char* end, char* out)
         {
-            // Skip the '//'
-            position += 2;
-            index = url.find_first_of("/?#", position);
-            host_.assign(url, position, index - position);
-            position = index;
-
-            // Extract any userinfo if there is any
-            index = host_.find('@');
-            if (index != std::string::npos)
+            const char* src = begin;
+            while (src < end)
             {
-                userinfo_.assign(host_, 0, index);
-                host_.assign(host_, index + 1, std::string::npos);
+                // Skip ahead to the next escape, moving everything before it
+                const char* percent = static_cast<const char*>(
+                    std::memchr(src, '%', end - src));
+                size_t run = (percent ? percent : end) - src;
+                if (out != src)
+                {
+                    std::memmove(out, src, run);
+                }
+                out += run;
+                src += run;
+                if (src == end)
+                {
+                    break;
+                }
+
+                // Not a valid escape if incomplete or with non-hex digits
+                if ((end - src) > 2)
+                {
+                    signed char high = Url::HEX_TO_DEC[static_cast<unsigned char>(src[1])];
+                    signed char low = Url::HEX_TO_DEC[static_cast<unsigned char>(src[2])];
+                    if (high != -1 && low != -1)
+                    {
+                        *out++ = static_cast<char>(high * 16 + low);
+                        src += 3;
+                        continue;
+                    }
+                }
+                *out++ = *src++;
             }
+            return out;
+        }
 
-            // Lowercase the hostname
-            std::transform(host_.begin(), host_.end(), host_.begin(), ::tolower);
+        /**
+         * Remove the sep-separated pieces of str whose names are matched by match,
+         * rewriting str in place. Separators are kept between the remaining pieces,
+         * except before the first. A trailing empty piece is dropped.
+         */
+        template<typename Match>
+        void remove_params_if(std::string& str, char sep, Match match)
+        {
+            char* data = &str[0];
+            size_t size = str.size();
+            size_t out = 0;
+            for (size_t previous = 0; previous < size; )
+            {
+                const char* found = static_cast<const char*>(
+                    std::memchr(data + previous, sep, size - previous));
+                size_t index = found ? (found - data) : size;
+                const char* equals = static_cast<const char*>(
+                    std::memchr(data + previous, '=', index - previous));
+                size_t name = (equals ? (equals - data) : index) - previous;
+
+                if (!match(data + previous, name))
+                {
+                    // The output is behind the piece by at least the separator's width
+                    if (out)
+                    {
+                        data[out++] = sep;
+                    }
+                    std::memmove(data + out, data + previous, index - previous);
+                    out += index - previous;
+                }
+                previous = index + 1;
+            }
+            str.resize(out);
+        }
 
-            // Try to find a port
-            index = host_.find(':');
-            if (index != std::string::npos)
+        /**
+         * Whether or not abspath would leave the path unchanged: it is not empty, and
+         * has no '.' or '..' segments and no empty segments, other than those before a
+         * leading '/' or after a trailing '/'.
+         */
+        bool is_normal_path(const std::string& path)
+        {
+            if (path.empty())
             {
-                std::string portText(host_, index + 1, std::string::npos);
-                host_.resize(index);
+                return false;
+            }
 
-                if (portText.empty())
+            size_t previous = 0;
+            for (size_t index = path.find('/')
+                ; ; previous = index + 1, index = path.find('/', previous))
+            {
+                bool last = (index == std::string::npos);
+                if (last)
                 {
-                    port_ = 0;
+                    index = path.size();
                 }
-                else
-                {
-                    try
-                    {
-                        port_ = std::stoi(portText, &index);
 
-                        if (index != portText.length())
+                switch (index - previous)
+                {
+                    case 0:
+                        if (previous != 0 && !last)
                         {
-                            // Malformed port
-                            throw UrlParseException("Port not a number: " + portText);
+                            return false;
                         }
-
-                        if (port_ > 65535)
+                        break;
+                    case 1:
+                        if (path[previous] == '.')
                         {
-                            throw UrlParseException("Port too high: " + portText);
+                            return false;
                         }
-                        else if (port_ < 0)
+                        break;
+                    case 2:
+                        if (path[previous] == '.' && path[previous + 1] == '.')
                         {
-                            throw UrlParseException("Port negative: " + portText);
+                            return false;
                         }
+                        break;
+                }
+
+                if (last)
+                {
+                    return true;
+                }
+            }
+        }
+
+        /**
+         * Write the equivalent of abspath of the path [data, data + size) to out,
+         * returning the new end of out. If Escape, the result is also escaped as the
+         * path would be, and may be up to three times as long plus one. Otherwise, it
+         * is at most one byte longer, and out may be data so long as there's room for
+         * that byte.
+         */
+        template<bool Escape>
+        char* normal_path(const char* data, size_t size, char* out)
+        {
+            const char* begin = out;
+
+            // The starting offset of each segment in the output
+            ScratchArray<size_t, 32> scratch;
+            size_t* starts = scratch.get(std::count(data, data + size, '/') + 2);
+            size_t depth = 0;
+
+            if (size && data[0] == '/')
+            {
+                *out++ = '/';
+                starts[depth++] = 0;
+            }
+
+            bool directory = false;
+            size_t previous = 0;
+            for (const char* slash = static_cast<const char*>(std::memchr(data, '/', size))
+                ; ; previous = slash - data + 1
+                  , slash = static_cast<const char*>(
+                      std::memchr(data + previous, '/', size - previous)))
+            {
+                bool last = (slash == nullptr);
+                size_t index = last ? size : (slash - data);
+                size_t length = index - previous;
+
+                if (length == 0)
+                {
+                    // Empty segments are skipped, but a trailing one marks a directory
+                    directory = last ? true : directory;
+                }
+                else if (length == 2 && data[previous] == '.' && data[previous + 1] == '.')
+                {
+                    if (depth)
+                    {
+                        out = const_cast<char*>(begin) + starts[--depth];
                     }
-                    catch (const std::invalid_argument&)
+                    directory = true;
+                }
+                else if (length == 1 && data[previous] == '.')
+                {
+                    directory = true;
+                }
+                else
+                {
+                    // Never ahead of the segment being read, so this may move it in place
+                    starts[depth++] = out - begin;
+                    if (Escape)
                     {
-                        // Malformed port
-                        throw UrlParseException("Port not a number: " + portText);
+                        out = escape_to(
+                            data + previous, data + index, out, Url::PATH, false);
                     }
-                    catch (const std::out_of_range&)
+                    else
                     {
-                        throw UrlParseException("Port out of integer range: " + portText);
+                        std::memmove(out, data + previous, length);
+                        out += length;
                     }
+                    *out++ = '/';
+                    directory = false;
+                }
+
+                if (last)
+                {
+                    break;
                 }
             }
+
+            if (!directory && out != begin)
+            {
+                --out;
+            }
+            else if (directory && out == begin)
+            {
+                *out++ = '/';
+            }
+            return out;
         }
 
-        if (position != std::string::npos)
+        /**
+         * Byte-wise comparison, as std::string's.
+         */
+        inline bool piece_less(const StringView& a, const StringView& b)
         {
-            path_.assign(url, position, std::string::npos);
+            size_t common = std::min(a.size(), b.size());
+            size_t index = 0;
+            if (common >= sizeof(uint64_t))
+            {
+                // Compare the first eight bytes at once, most significant first
+                uint64_t x;
+                uint64_t y;
+                std::memcpy(&x, a.data(), sizeof(x));
+                std::memcpy(&y, b.data(), sizeof(y));
+                if (x != y)
+                {
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+                    x = __builtin_bswap64(x);
+                    y = __builtin_bswap64(y);
+#endif
+                    return x < y;
+                }
+                index = sizeof(uint64_t);
+            }
 
-            index = path_.find('#');
-            if (index != std::string::npos)
+            for (; index < common; ++index)
             {
-                fragment_.assign(path_, index + 1, std::string::npos);
-                path_.resize(index);
+                if (a[index] != b[index])
+                {
+                    return static_cast<unsigned char>(a[index])
+                        < static_cast<unsigned char>(b[index]);
+                }
             }
+            return a.size() < b.size();
+        }
 
-            index = path_.find('?');
-            if (index != std::string::npos)
+        /**
+         * Sort the provided pieces, by insertion for the short lists that are typical.
+         */
+        void sort_pieces(StringView* pieces, size_t count)
+        {
+            if (count > 16)
+            {
+                std::sort(pieces, pieces + count, piece_less);
+                return;
+            }
+
+            for (size_t index = 1; index < count; ++index)
+            {
+                StringView piece = pieces[index];
+                size_t position = index;
+                for (; position && piece_less(piece, pieces[position - 1]); --position)
+                {
+                    pieces[position] = pieces[position - 1];
+                }
+                pieces[position] = piece;
+            }
+        }
+
+        /**
+         * Write the equivalent of stripping, sorting and escaping the sep-separated
+         * pieces of str to out, returning the new end of out. The output may be up to
+         * three times as long as str.
+         */
+        char* canonical_pieces(StringView str, char sep, char* out)
+        {
+            ScratchArray<StringView, 32> scratch;
+            StringView* pieces = scratch.get(std::count(str.begin(), str.end(), sep) + 1);
+            size_t count = 0;
+
+            // Empty pieces are dropped, as strip would
+            const char* start = str.begin();
+            for (const char* it = str.begin(); ; ++it)
+            {
+                if (it == str.end() || *it == sep)
+                {
+                    if (it != start)
+                    {
+                        pieces[count++] = StringView(start, it - start);
+                    }
+                    if (it == str.end())
+                    {
+                        break;
+                    }
+                    start = it + 1;
+                }
+            }
+
+            sort_pieces(pieces, count);
+
+            for (size_t index = 0; index < count; ++index)
+            {
+                if (index)
+                {
+                    *out++ = sep;
+                }
+                out = escape_to(pieces[index].begin(), pieces[index].end(), out,
+                    Url::QUERY, false);
+            }
+            return out;
+        }
+
+        /**
+         * Rewrite str, from start, as its non-empty sep-separated pieces, less those
+         * whose names the filter contains, sorted and deduplicated as requested.
+         */
+        void normalize_pieces(
+            std::string& str, size_t start, char sep, const Url::QueryOptions& options)
+        {
+            ScratchArray<StringView, 32> pieces_scratch;
+            StringView* pieces = pieces_scratch.get(
+                std::count(str.begin() + start, str.end(), sep) + 1);
+            size_t count = 0;
+
+            const char* data = str.data();
+            for (size_t previous = start; previous < str.size(); )
+            {
+                const char* found = static_cast<const char*>(
+                    std::memchr(data + previous, sep, str.size() - previous));
+                size_t index = found ? (found - data) : str.size();
+                if (index != previous)
+                {
+                    const char* equals = static_cast<const char*>(
+                        std::memchr(data + previous, '=', index - previous));
+                    size_t name = (equals ? (equals - data) : index) - previous;
+                    if (!options.filter || !options.filter->contains(data + previous, name))
+                    {
+                        pieces[count++] = StringView(data + previous, index - previous);
+                    }
+                }
+                previous = index + 1;
+            }
+
+            if (options.sort)
+            {
+                sort_pieces(pieces, count);
+            }
+
+            if (options.deduplicate && !options.sort && count > 1)
+            {
+                // Order by piece and then position to find the later duplicates, and
+                // empty them in place
+                ScratchArray<size_t, 32> order_scratch;
+                size_t* order = order_scratch.get(count);
+                for (size_t index = 0; index < count; ++index)
+                {
+                    order[index] = index;
+                }
+                std::sort(order, order + count, [pieces](size_t a, size_t b)
+                {
+                    return piece_less(pieces[a], pieces[b])
+                        || (!piece_less(pieces[b], pieces[a]) && a < b);
+                });
+                for (size_t index = count - 1; index > 0; --index)
+                {
+                    if (pieces[order[index]] == pieces[order[index - 1]])
+                    {
+                        pieces[order[index]] = StringView();
+                    }
+                }
+            }
+
+            // Join into scratch space, since the pieces still refer to str
+            ScratchArray<char, 1024> buffer_scratch;
+            char* buffer = buffer_scratch.get(str.size());
+            char* out = buffer;
+            const StringView* last = nullptr;
+            for (size_t index = 0; index < count; ++index)
+            {
+                const StringView& piece = pieces[index];
+                if (piece.empty() || (options.deduplicate && last && piece == *last))
+                {
+                    continue;
+                }
+                if (out != buffer)
+                {
+                    *out++ = sep;
+                }
+                out = std::copy(piece.begin(), piece.end(), out);
+                last = &piece;
+            }
+            str.assign(buffer, out - buffer);
+        }
+
+        /**
+         * Record the length of the component written after the length at the provided
+         * position and ending at end.
+         */
+        void store_length(char* at, const char* end)
+        {
+            uint32_t length = static_cast<uint32_t>(end - at - sizeof(length));
+            std::memcpy(at, &length, sizeof(length));
+        }
+
+        /**
+         * Write the length of str and then str itself, returning the new end of out.
+         */
+        char* put_component(char* out, const StringView& str)
+        {
+            char* start = out;
+            out = std::copy(str.begin(), str.end(), out + sizeof(uint32_t));
+            store_length(start, out);
+            return out;
+        }
+
+        /**
+         * The exception for a parse that failed, leaving failed with its host ending
+         * just before the port's ':'. The port runs to the end of the netloc and, as
+         * the parser always did, is reported lowercased.
+         */
+        UrlParseException parse_failure(
+            ParseStatus status, const UrlView& failed, const char* end)
+        {
+            const char* begin = failed.host().end() + 1;
+            const char* it = begin;
+            while (it != end && *it != '/' && *it != '?' && *it != '#')
+            {
+                ++it;
+            }
+            std::string port(begin, it);
+            std::transform(port.begin(), port.end(), port.begin(), ::tolower);
+            return UrlParseException(status, port);
+        }
+
+        /**
+         * Check that the hostname is valid, as Url::check_hostname does, returning its
+         * length without any optional trailing '.'.
+         */
+        size_t hostname_length(const std::string& host)
+        {
+            // Skip empty hostnames -- they are valid
+            if (host.empty())
             {
-                query_.assign(path_, index + 1, std::string::npos);
-                has_query_ = true;
-                path_.resize(index);
+                return 0;
             }
 
-            if (USES_PARAMS.find(scheme_) != USES_PARAMS.end())
+            size_t start = 0;
+            size_t end = host.find('.');
+            while (end != std::string::npos)
             {
-                index = path_.find(';');
-                if (index != std::string::npos)
+                if ((end - start) > 63)
+                {
+                    throw std::invalid_argument("Label too long.");
+                }
+                else if (end == start)
                 {
-                    params_.assign(path_, index + 1, std::string::npos);
-                    has_params_ = true;
-                    path_.resize(index);
+                    throw std::invalid_argument("Empty label.");
                 }
+
+                start = end + 1;
+                end = host.find('.', start);
+            }
+
+            // For the final segment
+            if ((host.size() - start) > 63)
+            {
+                throw std::invalid_argument("Label too long.");
+            }
+            else if (host.size() == start && start > 1)
+            {
+                // Remove a trailing empty segment
+                return start - 1;
+            }
+            return host.size();
+        }
+
+        /**
+         * Write the encoding of the url's canonical form into scratch, and return a view
+         * of it. It takes the same steps as canonicalize, without modifying the url.
+         *
+         * Each variable-length component is preceded by its length, so that different
+         * canonical forms never have the same encoding.
+         */
+        StringView canonical_encoding(const Url& url, ScratchArray<char, 1024>& scratch)
+        {
+            const std::string& scheme = url.scheme();
+            const std::string& path = url.path();
+            const std::string& params = url.params();
+
+            // The host is only copied when it needs punycoding
+            StringView host(url.host().data(), hostname_length(url.host()));
+            std::string encoded;
+            if (Punycode::needsPunycoding(url.host()))
+            {
+                encoded = Punycode::encodeHostname(host.str());
+                encoded.resize(hostname_length(encoded));
+                host = StringView(encoded);
             }
+
+            int port = url.port();
+            if (port && port == Schemes::defaultPort(url.schemeId()))
+            {
+                port = 0;
+            }
+
+            size_t start = url.query().find_first_not_of('?');
+            StringView query = (start == std::string::npos) ? StringView()
+                : StringView(url.query().data() + start, url.query().size() - start);
+
+            // The escaped components may be up to three times as long, and the path
+            // may gain a '/'
+            const size_t lengths = 5 * sizeof(uint32_t);
+            char* begin = scratch.get(lengths + scheme.size() + host.size() + sizeof(port)
+                + 3 * (path.size() + params.size() + query.size()) + 1);
+
+            char* out = put_component(begin, StringView(scheme));
+            out = put_component(out, host);
+            std::memcpy(out, &port, sizeof(port));
+            out += sizeof(port);
+
+            char* length = out;
+            out = normal_path<true>(path.data(), path.size(), out + sizeof(uint32_t));
+            store_length(length, out);
+
+            length = out;
+            out = canonical_pieces(StringView(params), ';', out + sizeof(uint32_t));
+            store_length(length, out);
+
+            length = out;
+            out = canonical_pieces(query, '&', out + sizeof(uint32_t));
+            store_length(length, out);
+
+            return StringView(begin, out - begin);
+        }
+    }
+
+    const char* UrlParseException::message(ParseStatus status)
+    {
+        switch (status)
+        {
+            case ParseStatus::OK:
+                return "OK";
+            case ParseStatus::PORT_NOT_NUMBER:
+                return "Port not a number";
+            case ParseStatus::PORT_OUT_OF_RANGE:
+                return "Port out of integer range";
+            case ParseStatus::PORT_TOO_HIGH:
+                return "Port too high";
+            case ParseStatus::PORT_NEGATIVE:
+                return "Port negative";
+        }
+        return "Unknown parse status"; // LCOV_EXCL_LINE
+    }
+
+    UrlView::UrlView()
+        : scheme_id_(Scheme::NONE), port_(0), has_params_(false), has_query_(false) { }
+
+    UrlView::UrlView(const std::string& url)
+        : scheme_id_(Scheme::NONE), port_(0), has_params_(false), has_query_(false)
+    {
+        ParseStatus status = parse_components(url.data(), url.size());
+        if (status != ParseStatus::OK)
+        {
+            throw parse_failure(status, *this, url.data() + url.size());
+        }
+    }
+
+    UrlView::UrlView(const char* url)
+        : scheme_id_(Scheme::NONE), port_(0), has_params_(false), has_query_(false)
+    {
+        size_t length = std::strlen(url);
+        ParseStatus status = parse_components(url, length);
+        if (status != ParseStatus::OK)
+        {
+            throw parse_failure(status, *this, url + length);
+        }
+    }
+
+    UrlView::UrlView(const char* data, size_t length)
+        : scheme_id_(Scheme::NONE), port_(0), has_params_(false), has_query_(false)
+    {
+        ParseStatus status = parse_components(data, length);
+        if (status != ParseStatus::OK)
+        {
+            throw parse_failure(status, *this, data + length);
         }
     }
 
+    ParseStatus UrlView::parse(const char* data, size_t length, UrlView& out)
+    {
+        out = UrlView();
+        return out.parse_components(data, length);
+    }
+
+    ParseStatus UrlView::parse_components(const char* data, size_t length)
+    {
+        // Every delimiter is found in a single forward walk over the input. At no point
+        // do we return to characters that have already been classified, with the
+        // exception of the rare 'scheme:digits' case, which has to look ahead.
+        const char* end = data + length;
+        const char* position = data;
+
+        // The would-be scheme is the run of SCHEME characters leading up to the first
+        // ':'. Since ':' is not itself a SCHEME character, stopping at the first
+        // non-SCHEME character finds it if it's eligible.
+        const char* it = data;
+        while (it != end && Url::SCHEME(*it))
+        {
+            ++it;
+        }
+
+        if (it != end && *it == ':')
+        {
+            // If there is nothing after the : or there are any non-digits, this is the
+            // scheme. Otherwise, it only is if it's a known protocol.
+            const char* digits = it + 1;
+            while (digits != end && Url::DIGIT(*digits))
+            {
+                ++digits;
+            }
+
+            Scheme id = Schemes::classifyInsensitive(data, it - data);
+            if (digits == it + 1
+                || digits != end
+                || (Schemes::flags(id) & Schemes::KNOWN))
+            {
+                scheme_ = StringView(data, it - data);
+                scheme_id_ = id;
+                position = it + 1;
+            }
+        }
+
+        // Search for the netloc, which runs until the first '/', '?', or '#'. Within it,
+        // the first '@' marks the end of the userinfo, and the first ':' after that
+        // marks the start of the port.
+        Scan::Delimiters delimiters(position, end);
+        it = delimiters.next();
+        if ((end - position) >= 2 && position[0] == '/' && position[1] == '/')
+        {
+            // Skip the '//', both of which were found as delimiters
+            position += 2;
+            delimiters.next();
+            const char* at = nullptr;
+            const char* colon = nullptr;
+            for (it = delimiters.next(); it != end; it = delimiters.next())
+            {
+                char c = *it;
+                if (c == '/' || c == '?' || c == '#')
+                {
+                    break;
+                }
+                else if (c == '@')
+                {
+                    if (!at)
+                    {
+                        at = it;
+                        colon = nullptr;
+                    }
+                }
+                else if (c == ':' && !colon)
+                {
+                    colon = it;
+                }
+            }
+
+            const char* host = position;
+            if (at)
+            {
+                userinfo_ = StringView(position, at - position);
+                host = at + 1;
+            }
+
+            if (colon)
+            {
+                host_ = StringView(host, colon - host);
+                ParseStatus status = parse_port(colon + 1, it, port_);
+                if (status != ParseStatus::OK)
+                {
+                    return status;
+                }
+            }
+            else
+            {
+                host_ = StringView(host, it - host);
+            }
+
+            // The netloc may consume the whole URL, in which case there is no path
+            if (it == end)
+            {
+                return ParseStatus::OK;
+            }
+            position = it;
+        }
+
+        // The path runs until the first ';' (for schemes that use params), '?', or '#'.
+        // Once the query has started, only a '#' is meaningful.
+        const char* semicolon = nullptr;
+        const char* question = nullptr;
+        for (; it != end; it = delimiters.next())
+        {
+            char c = *it;
+            if (c == '#')
+            {
+                break;
+            }
+            else if (c == '?')
+            {
+                question = it;
+                it = static_cast<const char*>(std::memchr(it + 1, '#', end - (it + 1)));
+                if (!it)
+                {
+                    it = end;
+                }
+                break;
+            }
+            else if (c == ';' && !semicolon)
+            {
+                semicolon = it;
+            }
+        }
+
+        if (it != end)
+        {
+            fragment_ = StringView(it + 1, end - (it + 1));
+        }
+
+        if (question)
+        {
+            query_ = StringView(question + 1, it - (question + 1));
+            has_query_ = true;
+            it = question;
+        }
+
+        if (semicolon && (Schemes::flags(scheme_id_) & Schemes::USES_PARAMS))
+        {
+            params_ = StringView(semicolon + 1, it - (semicolon + 1));
+            has_params_ = true;
+            it = semicolon;
+        }
+
+        path_ = StringView(position, it - position);
+        return ParseStatus::OK;
+    }
+
+    ParseStatus UrlView::parse_port(const char* begin, const char* end, int& port)
+    {
+        if (begin == end)
+        {
+            port = 0;
+            return ParseStatus::OK;
+        }
+
+        // This follows the rules of std::stoi -- leading whitespace, an optional sign,
+        // and then digits -- but reads the input in place and doesn't throw.
+        const char* it = begin;
+        while (it != end && (*it == ' ' || (*it >= '\t' && *it <= '\r')))
+        {
+            ++it;
+        }
+
+        bool negative = false;
+        if (it != end && (*it == '+' || *it == '-'))
+        {
+            negative = (*it == '-');
+            ++it;
+        }
+
+        // Once past the magnitude of any int, the value stops accumulating, but the
+        // digits are still consumed.
+        const uint64_t limit = static_cast<uint64_t>(std::numeric_limits<int>::max()) + 1;
+        const char* digits = it;
+        uint64_t value = 0;
+        for (; it != end && *it >= '0' && *it <= '9'; ++it)
+        {
+            if (value <= limit)
+            {
+                value = value * 10 + (*it - '0');
+            }
+        }
+
+        if (it == digits)
+        {
+            return ParseStatus::PORT_NOT_NUMBER;
+        }
+        else if (value > (negative ? limit : limit - 1))
+        {
+            return ParseStatus::PORT_OUT_OF_RANGE;
+        }
+        else if (it != end)
+        {
+            return ParseStatus::PORT_NOT_NUMBER;
+        }
+        else if (negative && value)
+        {
+            return ParseStatus::PORT_NEGATIVE;
+        }
+        else if (value > 65535)
+        {
+            return ParseStatus::PORT_TOO_HIGH;
+        }
+
+        port = static_cast<int>(value);
+        return ParseStatus::OK;
+    }
+
+    uint64_t UrlView::fingerprint() const
+    {
+        // Url lowercases the scheme and host, so they're lowercased on the way through
+        Hasher hasher;
+        Layout(*this).emit(hasher, true);
+        return hasher.digest();
+    }
+
+    void UrlView::unescapedPath(std::string& out) const
+    {
+        Url::unescaped(path_, out);
+    }
+
+    Url::Url()
+        : scheme_id_(Scheme::NONE), port_(0), has_params_(false), has_query_(false) { }
+
+    Url::Url(const std::string& url): Url(UrlView(url)) { }
+
+    Url::Url(const UrlView& view)
+        : scheme_(view.scheme().begin(), view.scheme().end())
+        , scheme_id_(view.schemeId())
+        , host_(view.host().begin(), view.host().end())
+        , port_(view.port())
+        , path_(view.path().begin(), view.path().end())
+        , params_(view.params().begin(), view.params().end())
+        , query_(view.query().begin(), view.query().end())
+        , fragment_(view.fragment().begin(), view.fragment().end())
+        , userinfo_(view.userinfo().begin(), view.userinfo().end())
+        , has_params_(view.hasParams())
+        , has_query_(view.hasQuery())
+    {
+        std::transform(scheme_.begin(), scheme_.end(), scheme_.begin(), ::tolower);
+        std::transform(host_.begin(), host_.end(), host_.begin(), ::tolower);
+    }
+
+    ParseStatus Url::parse(const char* data, size_t length, Url& out)
+    {
+        UrlView view;
+        ParseStatus status = UrlView::parse(data, length, view);
+        if (status == ParseStatus::OK)
+        {
+            out.assign(view);
+        }
+        return status;
+    }
+
+    Url& Url::reset(const StringView& url)
+    {
+        UrlView view;
+        ParseStatus status = UrlView::parse(url.data(), url.size(), view);
+        if (status != ParseStatus::OK)
+        {
+            throw parse_failure(status, view, url.end());
+        }
+        return assign(view);
+    }
+
     Url& Url::assign(const Url& other)
     {
         return (*this) = other;
     }
 
+    Url& Url::assign(const UrlView& view)
+    {
+        scheme_.assign(view.scheme().data(), view.scheme().size());
+        scheme_id_ = view.schemeId();
+        host_.assign(view.host().data(), view.host().size());
+        port_ = view.port();
+        path_.assign(view.path().data(), view.path().size());
+        params_.assign(view.params().data(), view.params().size());
+        query_.assign(view.query().data(), view.query().size());
+        fragment_.assign(view.fragment().data(), view.fragment().size());
+        userinfo_.assign(view.userinfo().data(), view.userinfo().size());
+        has_params_ = view.hasParams();
+        has_query_ = view.hasQuery();
+        std::transform(scheme_.begin(), scheme_.end(), scheme_.begin(), ::tolower);
+        std::transform(host_.begin(), host_.end(), host_.begin(), ::tolower);
+        return *this;
+    }
+
     bool Url::operator==(const Url& other) const
     {
         return (
@@ -324,28 +1162,12 @@ namespace Url
         return !operator==(other);
     }
 
-    bool Url::equiv(const Url& other)
+    bool Url::equiv(const Url& other) const
     {
-        Url self_(*this);
-        Url other_(other);
-
-        self_.strip()
-             .sort_query()
-             .defrag()
-             .deuserinfo()
-             .abspath()
-             .escape()
-             .punycode()
-             .remove_default_port();
-        other_.strip()
-              .sort_query()
-              .defrag()
-              .deuserinfo()
-              .abspath()
-              .escape()
-              .punycode()
-              .remove_default_port();
-        return self_ == other_;
+        // Comparing the encodings directly needs neither hashing nor allocation
+        ScratchArray<char, 1024> mine;
+        ScratchArray<char, 1024> theirs;
+        return canonical_encoding(*this, mine) == canonical_encoding(other, theirs);
     }
 
     std::string& Url::remove_repeats(std::string& str, const char chr)
@@ -370,105 +1192,154 @@ namespace Url
     std::string Url::fullpath() const
     {
         std::string result;
-        if (path_.empty() || path_[0] != '/')
+        fullpath(result);
+        return result;
+    }
+
+    void Url::fullpath(std::string& out) const
+    {
+        bool slash = path_.empty() || path_[0] != '/';
+        size_t size = (slash ? 1 : 0) + path_.size();
+        size += has_params_ ? params_.size() + 1 : 0;
+        size += has_query_ ? query_.size() + 1 : 0;
+        size += fragment_.empty() ? 0 : fragment_.size() + 1;
+
+        size_t offset = out.size();
+        out.resize(offset + size);
+        char* it = &out[offset];
+        auto append = [&it](const std::string& str)
+        {
+            std::memcpy(it, str.data(), str.size());
+            it += str.size();
+        };
+
+        if (slash)
         {
-            result.append(1, '/');
+            *it++ = '/';
         }
-        result.append(path_);
+        append(path_);
 
         if (has_params_)
         {
-            result.append(";");
-            result.append(params_);
+            *it++ = ';';
+            append(params_);
         }
 
         if (has_query_)
         {
-            result.append("?");
-            result.append(query_);
+            *it++ = '?';
+            append(query_);
         }
 
         if (!fragment_.empty())
         {
-            result.append("#");
-            result.append(fragment_);
+            *it++ = '#';
+            append(fragment_);
         }
-        return result;
     }
 
     std::string Url::str() const
     {
         std::string result;
+        str(result);
+        return result;
+    }
 
-        if (!scheme_.empty())
-        {
-            result.append(scheme_);
-            if (USES_NETLOC.find(scheme_) == USES_NETLOC.end())
-            {
-                result.append(":");
-            }
-            else
-            {
-                result.append("://");
-            }
-        }
-        else if (!host_.empty())
-        {
-            result.append("//");
-        }
+    void Url::str(std::string& out) const
+    {
+        UrlView components(view());
+        Layout layout(components);
+        size_t offset = out.size();
+        out.resize(offset + layout.size());
+        layout.write(&out[offset]);
+    }
 
-        if (!userinfo_.empty())
+    size_t Url::write(char* buffer, size_t capacity) const
+    {
+        UrlView components(view());
+        Layout layout(components);
+        if (layout.size() <= capacity)
         {
-            result.append(userinfo_);
-            result.append("@");
+            layout.write(buffer);
         }
+        return layout.size();
+    }
 
-        if (!host_.empty())
-        {
-            result.append(host_);
-        }
+    uint64_t Url::fingerprint() const
+    {
+        UrlView components(view());
+        Hasher hasher;
+        Layout(components).emit(hasher);
+        return hasher.digest();
+    }
 
-        if (port_)
-        {
-            result.append(":");
-            result.append(std::to_string(port_));
-        }
+    UrlView Url::view() const
+    {
+        UrlView result;
+        result.scheme_ = StringView(scheme_);
+        result.scheme_id_ = scheme_id_;
+        result.userinfo_ = StringView(userinfo_);
+        result.host_ = StringView(host_);
+        result.port_ = port_;
+        result.path_ = StringView(path_);
+        result.params_ = StringView(params_);
+        result.query_ = StringView(query_);
+        result.fragment_ = StringView(fragment_);
+        result.has_params_ = has_params_;
+        result.has_query_ = has_query_;
+        return result;
+    }
 
-        if (path_.empty())
-        {
-            if (!result.empty())
-            {
-                result.append("/");
-            }
-        }
-        else
+    Url& Url::canonicalize()
+    {
+        // The host is the only component that can fail, so it goes first
+        check_hostname(host_);
+        if (Punycode::needsPunycoding(host_))
         {
-            if (!host_.empty() && path_[0] != '/')
-            {
-                result.append(1, '/');
-            }
-            result.append(path_);
+            std::string encoded(Punycode::encodeHostname(host_));
+            check_hostname(encoded);
+            host_.swap(encoded);
         }
 
-        if (has_params_)
-        {
-            result.append(";");
-            result.append(params_);
-        }
+        remove_default_port();
+        userinfo_.clear();
+        fragment_.clear();
 
-        if (has_query_)
-        {
-            result.append("?");
-            result.append(query_);
-        }
+        // Each component is rewritten into scratch space and then copied back, so that
+        // its existing storage is reused.
+        ScratchArray<char, 1024> scratch;
+        char* buffer = scratch.get(
+            3 * std::max(path_.size(), std::max(query_.size(), params_.size())) + 1);
 
-        if (!fragment_.empty())
+        char* end = normal_path<true>(path_.data(), path_.size(), buffer);
+        path_.assign(buffer, end - buffer);
+
+        size_t start = query_.find_first_not_of('?');
+        StringView query = (start == std::string::npos)
+            ? StringView() : StringView(query_.data() + start, query_.size() - start);
+        end = canonical_pieces(query, '&', buffer);
+        query_.assign(buffer, end - buffer);
+        has_query_ = !query_.empty();
+
+        end = canonical_pieces(StringView(params_), ';', buffer);
+        params_.assign(buffer, end - buffer);
+        has_params_ = !params_.empty();
+
+        return *this;
+    }
+
+    CanonicalKey Url::canonicalKey(bool keepBytes) const
+    {
+        ScratchArray<char, 1024> scratch;
+        StringView encoding = canonical_encoding(*this, scratch);
+
+        CanonicalKey key;
+        key.hash_ = Hasher::hash(encoding.data(), encoding.size());
+        if (keepBytes)
         {
-            result.append("#");
-            result.append(fragment_);
+            key.bytes_.assign(encoding.data(), encoding.size());
         }
-
-        return result;
+        return key;
     }
 
     Url& Url::strip()
@@ -489,96 +1360,24 @@ namespace Url
 
     Url& Url::abspath()
     {
-        std::string copy;
-        std::vector<size_t> segment_starts;
-
-        if (path_.size() >= 1 && path_[0] == '/')
-        {
-            copy.append(1, '/');
-            segment_starts.push_back(0);
-        }
-
-        bool directory = false;
-        size_t previous = 0;
-        size_t index = 0;
-        for (index = path_.find('/')
-            ; index != std::string::npos
-            ; previous = index + 1, index = path_.find('/', index + 1))
-        {
-            // Skip empty segments
-            if (index - previous == 0)
-            {
-                continue;
-            }
-
-            if ((index - previous == 2)
-                && path_[previous] == '.'
-                && path_[previous + 1] == '.')
-            {
-                if (!segment_starts.empty())
-                {
-                    copy.resize(segment_starts.back());
-                    segment_starts.pop_back();
-                }
-                directory = true;
-            }
-            else if ((index - previous == 1) && path_[previous] == '.')
-            {
-                directory = true;
-            }
-            else
-            {
-                segment_starts.push_back(copy.length());
-                copy.append(path_, previous, index - previous);
-                copy.append(1, '/');
-                directory = false;
-            }
-        }
-
-        // Handle the last segment
-        index = path_.length();
-        if (previous == path_.length())
-        {
-            directory = true;
-        }
-        else if ((index - previous == 1) && path_[previous] == '.')
+        if (is_normal_path(path_))
         {
-            directory = true;
-        }
-        else if ((index - previous == 2)
-                && path_[previous] == '.'
-                && path_[previous + 1] == '.')
-        {
-            if (!segment_starts.empty())
-            {
-                copy.resize(segment_starts.back());
-            }
-            directory = true;
-        }
-        else
-        {
-            copy.append(path_, previous, index - previous);
-            copy.append(1, '/');
-            directory = false;
-        }
-
-        if (!directory && copy.size() >= 1)
-        {
-            copy.resize(copy.size() - 1);
-        }
-        else if (directory && copy.empty())
-        {
-            copy.append(1, '/');
+            return *this;
         }
-        path_.assign(copy);
 
+        // Compacted in place, with room for the one byte it may grow by
+        size_t size = path_.size();
+        path_.append(1, '/');
+        char* data = &path_[0];
+        char* end = normal_path<false>(data, size, data);
+        path_.resize(end - data);
         return *this;
     }
 
     Url& Url::relative_to(const Url& other)
     {
         // If this scheme does not use relative, return it unchanged
-        if (USES_RELATIVE.find(scheme_) == USES_RELATIVE.end())
+        if (!(Schemes::flags(scheme_id_) & Schemes::USES_RELATIVE))
         {
             return *this;
         }
@@ -587,6 +1386,7 @@ namespace Url
         if (scheme_.empty())
         {
             scheme_ = other.scheme_;
+            scheme_id_ = other.scheme_id_;
         }
 
         // If this is an absolute URL (or scheme-relative), return early
@@ -657,57 +1457,113 @@ namespace Url
 
     std::string& Url::escape(std::string& str, const CharacterClass& safe, bool strict)
     {
-        std::string copy(str);
-        size_t dest = 0;
-        // Allocate space pessimistically -- if every entity is expanded, it will take 3x
-        // the space.
-        str.resize(str.length() * 3);
-        for (size_t src = 0; src < copy.length(); ++src)
+        // First count the bytes that will be expanded and the escapes that will be
+        // decoded, and whether anything at all will change.
+        size_t grow = 0;
+        size_t shrink = 0;
+        bool changed = false;
+        for (size_t index = 0; index < str.size(); ++index)
         {
-            if (copy[src] == '%' && (copy.length() - src) >= 2)
+            index += Scan::plain(str.data() + index, str.size() - index, safe);
+            if (index == str.size())
             {
-                // Read ahead to see if there's a valid escape sequence. If not, treat
-                // this like a normal character.
-                if (HEX_TO_DEC[copy[src+1]] != -1 && HEX_TO_DEC[copy[src+2]] != -1)
-                {
-                    int value = (
-                        HEX_TO_DEC[copy[src+1]] * 16 + HEX_TO_DEC[copy[src+2]]);
+                break;
+            }
 
-                    // In strict mode, we can only unescape parameters if they are both
-                    // safe and not reserved
-                    if (!strict || (strict && safe(value) && !RESERVED(value)))
+            char c = str[index];
+            if (c == '%' && (str.size() - index) > 2)
+            {
+                signed char high = HEX_TO_DEC[static_cast<unsigned char>(str[index + 1])];
+                signed char low = HEX_TO_DEC[static_cast<unsigned char>(str[index + 2])];
+                if (high != -1 && low != -1)
+                {
+                    char value = static_cast<char>(high * 16 + low);
+                    if (!safe(value) || (strict && RESERVED(value)))
                     {
-                        // Replace src + 2 with that byte, advance src to consume it and
-                        // continue.
-                        src += 2;
-                        copy[src] = value;
+                        // Kept, but with uppercase digits
+                        changed = changed ||
+                            (str[index + 1] != ::toupper(str[index + 1])) ||
+                            (str[index + 2] != ::toupper(str[index + 2]));
                     }
                     else
                     {
-                        str[dest++] = copy[src++];
-                        str[dest++] = ::toupper(copy[src++]);
-                        str[dest++] = ::toupper(copy[src]);
-                        continue;
+                        ++shrink;
                     }
+                    index += 2;
+                    continue;
                 }
             }
 
-            if (!safe(copy[src]))
+            if (!safe(c))
             {
-                // Not safe -- replace with %XX
-                str[dest++] = '%';
-                str[dest++] = HEX.chars()[(copy[src] >> 4) & 0xF];
-                str[dest++] = HEX.chars()[copy[src] & 0xF];
+                ++grow;
             }
-            else
+        }
+
+        if (!grow && !shrink && !changed)
+        {
+            return str;
+        }
+
+        if (!grow)
+        {
+            // The output never gets ahead of the input, so it can be written over it
+            char* begin = &str[0];
+            char* end = escape_to(begin, begin + str.size(), begin, safe, strict);
+            str.resize(end - begin);
+        }
+        else if (!shrink)
+        {
+            // Grow once and fill from the back. Since a '%' is never a digit of an
+            // earlier escape, escapes can be recognized from the back as well.
+            size_t src = str.size();
+            size_t dest = src + 2 * grow;
+            str.resize(dest);
+            while (src > 0)
             {
-                str[dest++] = copy[src];
+                if (src > 2 && str[src - 3] == '%'
+                    && HEX_TO_DEC[static_cast<unsigned char>(str[src - 2])] != -1
+                    && HEX_TO_DEC[static_cast<unsigned char>(str[src - 1])] != -1)
+                {
+                    str[dest - 1] = ::toupper(str[src - 1]);
+                    str[dest - 2] = ::toupper(str[src - 2]);
+                    str[dest - 3] = '%';
+                    src -= 3;
+                    dest -= 3;
+                    continue;
+                }
+
+                char c = str[--src];
+                if (!safe(c))
+                {
+                    str[--dest] = HEX.chars()[c & 0xF];
+                    str[--dest] = HEX.chars()[(c >> 4) & 0xF];
+                    str[--dest] = '%';
+                }
+                else
+                {
+                    str[--dest] = c;
+                }
             }
         }
-        str.resize(dest);
+        else
+        {
+            // Some bytes grow and some shrink, so work from a copy
+            std::string copy(str);
+            str.resize(str.size() + 2 * grow - 2 * shrink);
+            escape_to(copy.data(), copy.data() + copy.size(), &str[0], safe, strict);
+        }
         return str;
     }
 
+    void Url::unescaped(const StringView& str, std::string& out)
+    {
+        size_t start = out.size();
+        out.resize(start + str.size());
+        char* end = unescape_to(str.begin(), str.end(), &out[start]);
+        out.resize(end - &out[0]);
+    }
+
     Url& Url::unescape()
     {
         unescape(path_);
@@ -719,45 +1575,42 @@ namespace Url
 
     std::string& Url::unescape(std::string& str)
     {
-        std::string copy(str);
-        size_t dest = 0;
-        for (size_t src = 0; src < copy.length(); ++src, ++dest)
-        {
-            if (copy[src] == '%' && (copy.length() - src) >= 2)
-            {
-                // Read ahead to see if there's a valid escape sequence. If not, treat
-                // this like a normal character.
-                if (HEX_TO_DEC[copy[src+1]] != -1 && HEX_TO_DEC[copy[src+2]] != -1)
-                {
-                    int value = (
-                        HEX_TO_DEC[copy[src+1]] * 16 + HEX_TO_DEC[copy[src+2]]);
-
-                    // Replace src + 2 with that byte, advance src to consume it and
-                    // continue.
-                    src += 2;
-                    str[dest] = value;
-                    continue;
-                }
-            }
-
-            // Either not a % or an incomplete entity
-            str[dest] = copy[src];
-        }
-        str.resize(dest);
+        // Decoding only ever shrinks the string, so it's done in place
+        char* begin = &str[0];
+        char* end = unescape_to(begin, begin + str.size(), begin);
+        str.resize(end - begin);
         return str;
     }
 
     Url& Url::deparam(const std::unordered_set<std::string>& blacklist)
     {
-        // Predicate is if it's present in the blacklist.
-        auto predicate = [blacklist](std::string& name, const std::string& value)
+        // Predicate is if it's present in the blacklist, once lowercased.
+        std::string lowered;
+        auto match = [&blacklist, &lowered](const char* name, size_t length)
         {
-            std::transform(name.begin(), name.end(), name.begin(), ::tolower);
-            return blacklist.find(name) != blacklist.end();
+            lowered.assign(name, length);
+            std::transform(lowered.begin(), lowered.end(), lowered.begin(), ::tolower);
+            return blacklist.find(lowered) != blacklist.end();
         };
 
-        setQuery(remove_params(query_, predicate, '&'));
-        setParams(remove_params(params_, predicate, ';'));
+        remove_params_if(query_, '&', match);
+        has_query_ = !query_.empty();
+        remove_params_if(params_, ';', match);
+        has_params_ = !params_.empty();
+        return *this;
+    }
+
+    Url& Url::deparam(const DeparamFilter& filter)
+    {
+        auto match = [&filter](const char* name, size_t length)
+        {
+            return filter.contains(name, length);
+        };
+
+        remove_params_if(query_, '&', match);
+        has_query_ = !query_.empty();
+        remove_params_if(params_, ';', match);
+        has_params_ = !params_.empty();
         return *this;
     }
 
@@ -826,52 +1679,63 @@ namespace Url
         return *this;
     }
 
-    std::string& Url::split_sort_join(std::string& str, const char glue)
+    Url& Url::normalizeQuery(const QueryOptions& options)
     {
-        // Return early if empty
-        if (str.empty())
-        {
-            return str;
-        }
+        size_t start = query_.find_first_not_of('?');
+        normalize_pieces(query_, start == std::string::npos ? query_.size() : start,
+            '&', options);
+        has_query_ = !query_.empty();
+        normalize_pieces(params_, 0, ';', options);
+        has_params_ = !params_.empty();
+        return *this;
+    }
 
-        // Split
-        std::vector<std::string> pieces;
-        std::stringstream stream(str);
-        std::string item;
-        while (getline(stream, item, glue))
+    std::string& Url::split_sort_join(std::string& str, const char glue)
+    {
+        // Split into views of the pieces, without a trailing empty piece
+        ScratchArray<StringView, 32> pieces_scratch;
+        StringView* pieces = pieces_scratch.get(
+            std::count(str.begin(), str.end(), glue) + 1);
+        size_t count = 0;
+        const char* data = str.data();
+        for (size_t previous = 0; previous < str.size(); )
         {
-            pieces.push_back(item);
+            const char* found = static_cast<const char*>(
+                std::memchr(data + previous, glue, str.size() - previous));
+            size_t index = found ? (found - data) : str.size();
+            pieces[count++] = StringView(data + previous, index - previous);
+            previous = index + 1;
         }
 
-        // Return early if it's just a single element
-        if (pieces.size() == 1)
+        // Return early if it's empty or just a single element
+        if (count <= 1)
         {
             return str;
         }
 
-        // Sort
-        std::sort(pieces.begin(), pieces.end());
+        sort_pieces(pieces, count);
 
-        // Join (at this point we know that there's at least one element)
-        std::stringstream output;
-        for (auto it = pieces.begin(); it != (pieces.end() - 1); ++it)
+        // Join into scratch space, since the pieces still refer to str
+        ScratchArray<char, 1024> buffer_scratch;
+        char* buffer = buffer_scratch.get(str.size());
+        char* out = buffer;
+        for (size_t index = 0; index < count; ++index)
         {
-            output << *it << glue;
+            if (index)
+            {
+                *out++ = glue;
+            }
+            out = std::copy(pieces[index].begin(), pieces[index].end(), out);
         }
-        output << pieces.back();
-        str.assign(output.str());
+        str.assign(buffer, out - buffer);
         return str;
     }
 
     Url& Url::remove_default_port()
     {
-        if (port_ && !scheme_.empty())
+        if (port_ && port_ == Schemes::defaultPort(scheme_id_))
         {
-            auto it = PORTS.find(scheme_);
-            if (it != PORTS.end() && port_ == it->second)
-            {
-                port_ = 0;
-            }
+            port_ = 0;
         }
         return *this;
     }
@@ -924,39 +1788,7 @@ namespace Url
 
     void Url::check_hostname(std::string& host)
     {
-        // Skip empty hostnames -- they are valid
-        if (host.empty())
-        {
-            return;
-        }
-
-        size_t start = 0;
-        size_t end = host.find('.');
-        while (end != std::string::npos)
-        {
-            if ((end - start) > 63)
-            {
-                throw std::invalid_argument("Label too long.");
-            }
-            else if (end == start)
-            {
-                throw std::invalid_argument("Empty label.");
-            }
-
-            start = end + 1;
-            end = host.find('.', start);
-        }
-
-        // For the final segment
-        if ((host.size() - start) > 63)
-        {
-            throw std::invalid_argument("Label too long.");
-        }
-        else if (host.size() == start && start > 1)
-        {
-            // Remove a trailing empty segment
-            host.resize(start - 1);
-        }
+        host.resize(hostname_length(host));
     }
 
 };
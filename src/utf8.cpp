@@ -7,8 +7,42 @@
 namespace Url
 {
 
+    const char* Utf8::message(Utf8::Status status)
+    {
+        switch (status)
+        {
+            case Status::OK:
+                return "OK";
+            case Status::LOW_START_BYTE:
+                return "Low UTF-8 start byte";
+            case Status::HIGH_START_BYTE:
+                return "High UTF-8 start byte";
+            case Status::TERMINATED_EARLY:
+                return "UTF-8 sequence terminated early.";
+            case Status::INVALID_CONTINUATION:
+                return "Invalid continuation byte";
+            case Status::CODEPOINT_TOO_HIGH:
+                return "Code point too high.";
+        }
+        return "Unknown UTF-8 status"; // LCOV_EXCL_LINE
+    }
+
     Utf8::codepoint_t Utf8::readCodepoint(
         std::string::const_iterator& it, const std::string::const_iterator& end)
+    {
+        codepoint_t value = 0;
+        Status status = readCodepoint(it, end, value);
+        if (status != Status::OK)
+        {
+            throw std::invalid_argument(message(status));
+        }
+        return value;
+    }
+
+    Utf8::Status Utf8::readCodepoint(
+        std::string::const_iterator& it,
+        const std::string::const_iterator& end,
+        Utf8::codepoint_t& value)
     {
         Utf8::char_t current = static_cast<Utf8::char_t>(*it++);
         if (current & 0x80)
@@ -20,7 +54,7 @@ namespace Url
             if (current < 0xC0)
             {
                 // Invalid sequence
-                throw std::invalid_argument("Low UTF-8 start byte");
+                return Status::LOW_START_BYTE;
             }
             else if (current < 0xE0)
             {
@@ -42,37 +76,38 @@ namespace Url
             }
             else
             {
-                throw std::invalid_argument("High UTF-8 start byte");
+                return Status::HIGH_START_BYTE;
             }
 
             for (; bytes > 0; --bytes) {
                 if (it == end)
                 {
-                    throw std::invalid_argument("UTF-8 sequence terminated early.");
+                    return Status::TERMINATED_EARLY;
                 }
 
                 current = static_cast<unsigned char>(*it++);
                 // Ensure the first two bits are 10
                 if ((current & 0xC0) != 0x80)
                 {
-                    throw std::invalid_argument("Invalid continuation byte");
+                    return Status::INVALID_CONTINUATION;
                 }
                 result = (result << 6) | (current & 0x3F);
             }
 
-            return result;
+            value = result;
         }
         else
         {
-            return current;
+            value = current;
         }
+        return Status::OK;
     }
 
     std::string& Utf8::writeCodepoint(std::string& str, Utf8::codepoint_t value)
     {
         if (value > MAX_CODEPOINT)
         {
-            throw std::invalid_argument("Code point too high.");
+            throw std::invalid_argument(message(Status::CODEPOINT_TOO_HIGH));
         }
         else if (value <= 0x007F)
         {
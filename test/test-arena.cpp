@@ -0,0 +1,86 @@
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "arena.h"
+
+TEST(ArenaTest, Allocate)
+{
+    Url::Arena arena(64);
+    char* a = static_cast<char*>(arena.allocate(10, 1));
+    char* b = static_cast<char*>(arena.allocate(10, 1));
+    EXPECT_EQ(a + 10, b);
+    EXPECT_EQ(20, arena.allocated());
+}
+
+TEST(ArenaTest, Alignment)
+{
+    Url::Arena arena(64);
+    arena.allocate(1, 1);
+    void* aligned = arena.allocate(8, 8);
+    EXPECT_EQ(0, reinterpret_cast<uintptr_t>(aligned) % 8);
+}
+
+TEST(ArenaTest, Grows)
+{
+    Url::Arena arena(64);
+    char* a = static_cast<char*>(arena.allocate(60, 1));
+    char* b = static_cast<char*>(arena.allocate(10, 1));
+    EXPECT_NE(a + 60, b);
+
+    // Oversized requests are satisfied with their own block
+    char* big = static_cast<char*>(arena.allocate(1000, 1));
+    big[999] = 'a';
+    EXPECT_EQ(1070, arena.allocated());
+}
+
+TEST(ArenaTest, Release)
+{
+    Url::Arena arena(64);
+    char* first = static_cast<char*>(arena.allocate(60, 1));
+    arena.allocate(60, 1);
+    arena.release();
+    EXPECT_EQ(0, arena.allocated());
+    EXPECT_EQ(first, arena.allocate(60, 1));
+}
+
+TEST(ArenaTest, ReleaseEmpty)
+{
+    Url::Arena arena(64);
+    arena.release();
+    EXPECT_EQ(0, arena.allocated());
+}
+
+TEST(ArenaTest, OversizedFirst)
+{
+    Url::Arena arena(64);
+    arena.allocate(1000, 1);
+    arena.release();
+    char* a = static_cast<char*>(arena.allocate(64, 1));
+    a[63] = 'a';
+    EXPECT_EQ(64, arena.allocated());
+}
+
+TEST(ArenaTest, Allocator)
+{
+    Url::Arena arena;
+    Url::ArenaAllocator<int> allocator(arena);
+    std::vector<int, Url::ArenaAllocator<int>> numbers(allocator);
+    for (int i = 0; i < 100; ++i)
+    {
+        numbers.push_back(i);
+    }
+    EXPECT_EQ(99, numbers.back());
+    EXPECT_LT(100 * sizeof(int), arena.allocated());
+
+    typedef std::basic_string<char, std::char_traits<char>, Url::ArenaAllocator<char>>
+        string_t;
+    string_t str("a string long enough to need an allocation", arena);
+    EXPECT_EQ(Url::ArenaAllocator<char>(arena), str.get_allocator());
+    EXPECT_EQ(allocator, str.get_allocator());
+
+    Url::Arena other;
+    EXPECT_NE(allocator, Url::ArenaAllocator<int>(other));
+}
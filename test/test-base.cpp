@@ -0,0 +1,235 @@
+#include <gtest/gtest.h>
+
+#include <string>
+#include <vector>
+
+#include "base.h"
+#include "url.h"
+
+namespace
+{
+    std::string resolve(const Url::BaseUrl& base, const std::string& href)
+    {
+        std::string out;
+        EXPECT_EQ(Url::ParseStatus::OK, base.resolve(href, out));
+        return out;
+    }
+
+    std::string expected(const std::string& base, const std::string& href)
+    {
+        return Url::Url(href).relative_to(Url::Url(base)).str();
+    }
+}
+
+TEST(BaseUrlTest, Relative)
+{
+    Url::BaseUrl base("http://user@Foo.com:8080/a/b/c.html;p?q=1#f");
+    EXPECT_EQ("http://user@foo.com:8080/a/b/d.html", resolve(base, "d.html"));
+    EXPECT_EQ("http://user@foo.com:8080/a/b/d/e;x?y#z", resolve(base, "d/e;x?y#z"));
+    EXPECT_EQ("http://user@foo.com:8080/a/b/../d", resolve(base, "../d"));
+}
+
+TEST(BaseUrlTest, MatchesRelativeTo)
+{
+    std::vector<std::string> bases = {
+        "http://user@Foo.com:8080/a/b/c.html;p?q=1#f",
+        "http://foo.com",
+        "http://foo.com/",
+        "https://foo.com/a/b?q#f",
+        "foo/bar",
+        "bar",
+        "/foo/bar",
+        "//foo.com/a/b",
+        "mailto:user@foo.com",
+        "file:///a/b/c",
+        ""
+    };
+    std::vector<std::string> hrefs = {
+        "",
+        "d.html",
+        "d/e;x?y#z",
+        "../d",
+        "/absolute/path",
+        "//Other.com/path",
+        "HTTPS://Other.com/path",
+        "http:relative/path",
+        "https:relative/path",
+        "?query",
+        "#fragment",
+        ";params",
+        ";params?query",
+        "?query#fragment",
+        "mailto:someone@example.com",
+        "javascript:void(0)",
+        "path;params?query#fragment"
+    };
+    for (auto base = bases.begin(); base != bases.end(); ++base)
+    {
+        Url::BaseUrl prepared(*base);
+        for (auto href = hrefs.begin(); href != hrefs.end(); ++href)
+        {
+            EXPECT_EQ(expected(*base, *href), resolve(prepared, *href))
+                << "base: " << *base << " href: " << *href;
+        }
+    }
+}
+
+TEST(BaseUrlTest, FromUrl)
+{
+    Url::Url url("http://foo.com/a/b");
+    Url::BaseUrl base(url);
+    EXPECT_EQ(url, base.url());
+    EXPECT_EQ("http://foo.com/a/c", resolve(base, "c"));
+}
+
+TEST(BaseUrlTest, RelativeBasePath)
+{
+    Url::Url url("http://foo.com");
+    url.setPath("a/b");
+    Url::BaseUrl base(url);
+    EXPECT_EQ(Url::Url("c").relative_to(url).str(), resolve(base, "c"));
+    EXPECT_EQ(Url::Url(";p").relative_to(url).str(), resolve(base, ";p"));
+
+    // A base without a host leaves relative paths as they are
+    Url::BaseUrl scheme("http://");
+    Url::Url resolved;
+    EXPECT_EQ(Url::ParseStatus::OK, scheme.resolve("foo.com%2f", resolved));
+    EXPECT_EQ(Url::Url("foo.com%2f").relative_to(scheme.url()), resolved);
+    EXPECT_EQ("", resolved.host());
+}
+
+TEST(BaseUrlTest, IntoUrl)
+{
+    Url::BaseUrl base("http://Foo.com/a/b?q#f");
+    Url::Url url("http://bar.com/x");
+    std::vector<std::string> hrefs = {
+        "c", "/d", "", "?r", "HTTPS://Bar.com/e", "ftp:f", "//Baz.com", "mailto:x@y.com"
+    };
+    for (auto href = hrefs.begin(); href != hrefs.end(); ++href)
+    {
+        EXPECT_EQ(Url::ParseStatus::OK, base.resolve(*href, url));
+        EXPECT_EQ(Url::Url(*href).relative_to(base.url()), url) << "href: " << *href;
+    }
+    EXPECT_NE(Url::ParseStatus::OK, base.resolve("http://foo.com:99999999999/", url));
+    EXPECT_EQ(Url::Url("mailto:x@y.com"), url);
+}
+
+TEST(BaseUrlTest, Appends)
+{
+    Url::BaseUrl base("http://foo.com/a/b");
+    std::string out("prefix ");
+    EXPECT_EQ(Url::ParseStatus::OK, base.resolve("c", out));
+    EXPECT_EQ(Url::ParseStatus::OK, base.resolve("/d", out));
+    EXPECT_EQ("prefix http://foo.com/a/chttp://foo.com/d", out);
+}
+
+TEST(BaseUrlTest, InvalidHref)
+{
+    Url::BaseUrl base("http://foo.com/a/b");
+    std::string out("unchanged");
+    EXPECT_NE(Url::ParseStatus::OK, base.resolve("http://foo.com:99999999999/", out));
+    EXPECT_EQ("unchanged", out);
+}
+
+TEST(BaseUrlTest, InvalidBase)
+{
+    EXPECT_THROW(Url::BaseUrl("http://foo.com:99999999999/"), Url::UrlParseException);
+}
+
+namespace
+{
+    std::vector<std::string> links(const Url::ResolvedLinks& resolved)
+    {
+        std::vector<std::string> result;
+        for (size_t row = 0; row < resolved.size(); ++row)
+        {
+            result.push_back(resolved.get(row).str());
+        }
+        return result;
+    }
+}
+
+TEST(ResolveAllTest, Normalizes)
+{
+    Url::BaseUrl base("http://foo.com/a/b/index.html");
+    std::vector<Url::StringView> hrefs = {
+        "c.html#top", "../d e.html", "./x/../y", "//Other.com/z?q#f"
+    };
+    Url::ResolvedLinks resolved;
+    Url::resolveAll(base, hrefs.data(), hrefs.size(), resolved);
+    std::vector<std::string> expected = {
+        "http://foo.com/a/b/c.html",
+        "http://foo.com/a/d%20e.html",
+        "http://foo.com/a/b/y",
+        "http://other.com/z?q"
+    };
+    EXPECT_EQ(expected, links(resolved));
+    for (size_t row = 0; row < resolved.size(); ++row)
+    {
+        std::string href = hrefs[resolved.source[row]].str();
+        Url::Url url(Url::Url(href).relative_to(base.url()).defrag().abspath().escape());
+        EXPECT_EQ(url.str(), resolved.get(row).str());
+        EXPECT_EQ(url.fingerprint(), resolved.fingerprint[row]);
+    }
+}
+
+TEST(ResolveAllTest, FiltersSchemes)
+{
+    Url::BaseUrl base("https://foo.com/a/");
+    std::vector<Url::StringView> hrefs = {
+        "b", "mailto:someone@foo.com", "javascript:void(0)", "ftp://foo.com/c",
+        "http://foo.com:99999999999/", "http://bar.com/"
+    };
+    Url::ResolvedLinks resolved;
+    Url::resolveAll(base, hrefs.data(), hrefs.size(), resolved);
+    std::vector<std::string> expected = { "https://foo.com/a/b", "http://bar.com/" };
+    EXPECT_EQ(expected, links(resolved));
+    std::vector<uint32_t> sources = { 0, 5 };
+    EXPECT_EQ(sources, resolved.source);
+
+    Url::ResolveOptions options;
+    options.schemes = Url::ResolveOptions::scheme(Url::Scheme::FTP)
+        | Url::ResolveOptions::scheme(Url::Scheme::UNKNOWN);
+    Url::resolveAll(base, hrefs.data(), hrefs.size(), resolved, options);
+    expected = { "mailto:someone@foo.com", "javascript:void(0)", "ftp://foo.com/c" };
+    EXPECT_EQ(expected, links(resolved));
+}
+
+TEST(ResolveAllTest, Deduplicates)
+{
+    Url::BaseUrl base("http://foo.com/a/b");
+    std::vector<Url::StringView> hrefs = {
+        "c", "/a/c", "c#frag", "./c", "d", "HTTP://FOO.COM/a/c", "d"
+    };
+    Url::ResolvedLinks resolved;
+    Url::resolveAll(base, hrefs.data(), hrefs.size(), resolved);
+    std::vector<std::string> expected = { "http://foo.com/a/c", "http://foo.com/a/d" };
+    EXPECT_EQ(expected, links(resolved));
+    std::vector<uint32_t> sources = { 0, 4 };
+    EXPECT_EQ(sources, resolved.source);
+    EXPECT_EQ(std::string("http://foo.com/a/chttp://foo.com/a/d"), resolved.arena);
+
+    Url::ResolveOptions options;
+    options.deduplicate = false;
+    Url::resolveAll(base, hrefs.data(), hrefs.size(), resolved, options);
+    EXPECT_EQ(hrefs.size(), resolved.size());
+}
+
+TEST(ResolveAllTest, ManyLinks)
+{
+    Url::BaseUrl base("http://foo.com/dir/");
+    std::vector<std::string> owned;
+    for (size_t i = 0; i < 5000; ++i)
+    {
+        owned.push_back("page" + std::to_string(i % 1000) + ".html");
+    }
+    std::vector<Url::StringView> hrefs(owned.begin(), owned.end());
+    Url::ResolvedLinks resolved;
+    Url::resolveAll(base, hrefs.data(), hrefs.size(), resolved);
+    ASSERT_EQ(1000u, resolved.size());
+    for (size_t row = 0; row < resolved.size(); ++row)
+    {
+        EXPECT_EQ(row, resolved.source[row]);
+        EXPECT_EQ("http://foo.com/dir/" + owned[row], resolved.get(row).str());
+    }
+}
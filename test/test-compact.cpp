@@ -0,0 +1,322 @@
+#include <gtest/gtest.h>
+
+#include <cstdlib>
+#include <new>
+#include <string>
+#include <utility>
+
+#include "compact.h"
+#include "deparam.h"
+
+namespace
+{
+    // The number of allocations made through the global operator new
+    size_t allocations = 0;
+}
+
+// Replaced for the whole test binary, so that tests can count heap allocations. Every
+// form is replaced, so that none is left to a sanitizer's own allocator.
+void* operator new(size_t size)
+{
+    ++allocations;
+    void* result = std::malloc(size ? size : 1);
+    if (!result)
+    {
+        throw std::bad_alloc(); // LCOV_EXCL_LINE
+    }
+    return result;
+}
+
+void* operator new[](size_t size)
+{
+    return operator new(size);
+}
+
+void operator delete(void* pointer) noexcept
+{
+    std::free(pointer);
+}
+
+void operator delete[](void* pointer) noexcept
+{
+    std::free(pointer);
+}
+
+// Used by anything linked in that was compiled as C++14 or later
+void operator delete(void* pointer, size_t) noexcept
+{
+    std::free(pointer);
+}
+
+void operator delete[](void* pointer, size_t) noexcept
+{
+    std::free(pointer);
+}
+
+TEST(CompactTest, Components)
+{
+    Url::CompactUrl compact("http://user@Foo.com:8080/path;params?query#fragment");
+    EXPECT_EQ("http", compact.scheme());
+    EXPECT_EQ(Url::Scheme::HTTP, compact.schemeId());
+    EXPECT_EQ("user", compact.userinfo());
+    EXPECT_EQ("foo.com", compact.host());
+    EXPECT_EQ(8080, compact.port());
+    EXPECT_EQ("/path", compact.path());
+    EXPECT_EQ("params", compact.params());
+    EXPECT_EQ("query", compact.query());
+    EXPECT_EQ("fragment", compact.fragment());
+    EXPECT_EQ("http://user@foo.com:8080/path;params?query#fragment", compact.str());
+    EXPECT_EQ("/path;params?query#fragment", compact.fullpath());
+}
+
+TEST(CompactTest, StoresSerializedForm)
+{
+    Url::CompactUrl compact("http://foo.com/path?query");
+    EXPECT_EQ("http://foo.com/path?query", compact.view());
+    EXPECT_EQ(compact.view().data() + 7, compact.host().data());
+    EXPECT_EQ(compact.view().data() + 14, compact.path().data());
+}
+
+TEST(CompactTest, RoundTrip)
+{
+    std::vector<std::string> examples = {
+        "http://foo.com",
+        "http://foo.com/;?",
+        "foo;params?query#fragment",
+        "path",
+        "//foo.com/path",
+        "mailto:user@example.com",
+        "file:///tmp/junk.txt",
+        "http://foo.com:80/a;b;c?d&e#f",
+        ""
+    };
+    for (auto it = examples.begin(); it != examples.end(); ++it)
+    {
+        Url::Url url(*it);
+        Url::CompactUrl compact(url);
+        EXPECT_EQ(url.str(), compact.str());
+        EXPECT_EQ(url.fullpath(), compact.fullpath());
+        EXPECT_EQ(url, compact.url());
+    }
+}
+
+TEST(CompactTest, FromString)
+{
+    std::vector<std::string> examples = {
+        "HTTP://User@Foo.COM:8080/Path;Params?Query#Fragment",
+        "Foo;params?query#fragment",
+        "//FOO.com/path",
+        "MAILTO:User@Example.com",
+        ""
+    };
+    for (auto it = examples.begin(); it != examples.end(); ++it)
+    {
+        Url::Url url(*it);
+        Url::Arena arena;
+        Url::CompactUrl heap(*it);
+        Url::CompactUrl compact(*it, arena);
+        EXPECT_EQ(url.str(), compact.str());
+        EXPECT_EQ(url, compact.url());
+        EXPECT_EQ(url.schemeId(), compact.schemeId());
+        EXPECT_EQ(compact, heap);
+    }
+
+    try
+    {
+        Url::Arena arena;
+        Url::CompactUrl compact("http://foo.com:99999/", arena);
+        FAIL() << "Expected UrlParseException";
+    }
+    catch (const Url::UrlParseException& exc)
+    {
+        EXPECT_STREQ("Port too high: 99999", exc.what());
+    }
+}
+
+TEST(CompactTest, RoundTripFromComponents)
+{
+    // Components that don't survive a round trip through str() and back
+    Url::Url url("http://foo.com/");
+    url.setPath("a;b").setHost("").setPort(-5);
+    Url::CompactUrl compact(url);
+    EXPECT_EQ(url.str(), compact.str());
+    EXPECT_EQ(url, compact.url());
+    EXPECT_EQ("a;b", compact.path());
+    EXPECT_EQ(-5, compact.port());
+}
+
+TEST(CompactTest, CopyAndMove)
+{
+    Url::CompactUrl original("http://foo.com/path");
+    Url::CompactUrl copy(original);
+    EXPECT_EQ(original, copy);
+    EXPECT_NE(original.view().data(), copy.view().data());
+
+    Url::CompactUrl moved(std::move(copy));
+    EXPECT_EQ(original, moved);
+    EXPECT_EQ("", copy.str());
+    EXPECT_EQ("", copy.host());
+
+    Url::CompactUrl assigned("http://bar.com/");
+    assigned = original;
+    EXPECT_EQ(original, assigned);
+    assigned = assigned;
+    EXPECT_EQ(original, assigned);
+
+    Url::CompactUrl move_assigned("http://bar.com/");
+    move_assigned = std::move(assigned);
+    EXPECT_EQ(original, move_assigned);
+}
+
+TEST(CompactTest, Fingerprint)
+{
+    Url::Url url("http://user@foo.com:8080/path;params?query#fragment");
+    EXPECT_EQ(url.fingerprint(), Url::CompactUrl(url).fingerprint());
+}
+
+TEST(CompactTest, Equality)
+{
+    Url::CompactUrl a("http://foo.com/path");
+    EXPECT_EQ(a, Url::CompactUrl("http://foo.com/path"));
+    EXPECT_NE(a, Url::CompactUrl("http://foo.com/path?"));
+    EXPECT_NE(a, Url::CompactUrl("http://foo.com:8080/path"));
+}
+
+TEST(CompactTest, Setters)
+{
+    Url::CompactUrl compact("http://foo.com/");
+    compact.setScheme("https")
+           .setHost("bar.com")
+           .setPort(8443)
+           .setPath("/path")
+           .setParams("params")
+           .setQuery("query")
+           .setFragment("fragment")
+           .setUserinfo("user");
+    EXPECT_EQ("https://user@bar.com:8443/path;params?query#fragment", compact.str());
+}
+
+TEST(CompactTest, Transforms)
+{
+    std::string url("HTTP://user@www.K\xc3\xbc" "ndigen.de:80/a/./b/../c d;x=1;y=2?b=2&&a=1&utm=3#frag");
+    Url::Url expected(url);
+    Url::CompactUrl compact(url);
+
+    std::unordered_set<std::string> blacklist = { "utm" };
+    expected.strip().deparam(blacklist).sort_query().abspath().escape()
+        .remove_default_port().deuserinfo().defrag().punycode();
+    compact.strip().deparam(blacklist).sort_query().abspath().escape()
+        .remove_default_port().deuserinfo().defrag().punycode();
+    EXPECT_EQ(expected.str(), compact.str());
+
+    expected.unpunycode().host_reversed().unescape();
+    compact.unpunycode().host_reversed().unescape();
+    EXPECT_EQ(expected.str(), compact.str());
+
+    auto predicate = [](std::string& name, std::string& value) { return name == "a"; };
+    EXPECT_EQ(
+        Url::Url("http://foo.com/?a=1&b=2").deparam(predicate).str(),
+        Url::CompactUrl("http://foo.com/?a=1&b=2").deparam(predicate).str());
+
+    Url::DeparamFilter filter(blacklist);
+    EXPECT_EQ(
+        Url::Url(url).deparam(filter).str(),
+        Url::CompactUrl(url).deparam(filter).str());
+}
+
+TEST(CompactTest, RelativeTo)
+{
+    EXPECT_EQ("http://foo.com/a/c",
+        Url::CompactUrl("c").relative_to("http://foo.com/a/b").str());
+    EXPECT_EQ("http://foo.com/a/c",
+        Url::CompactUrl("c").relative_to(Url::Url("http://foo.com/a/b")).str());
+}
+
+TEST(CompactTest, TooLong)
+{
+    std::string url = "http://foo.com/" + std::string(70000, 'a');
+    ASSERT_THROW(Url::CompactUrl compact(url), std::length_error);
+}
+
+TEST(CompactTest, Arena)
+{
+    Url::Arena arena;
+    Url::CompactUrl compact("http://foo.com/path", arena);
+    EXPECT_EQ("http://foo.com/path", compact.str());
+    EXPECT_EQ(19, arena.allocated());
+
+    Url::CompactUrl from_url(Url::Url("http://bar.com/"), arena);
+    EXPECT_EQ("http://bar.com/", from_url.str());
+    EXPECT_EQ(34, arena.allocated());
+
+    // Transforms allocate from the arena too
+    compact.setPath("/other");
+    EXPECT_EQ("http://foo.com/other", compact.str());
+    EXPECT_EQ(54, arena.allocated());
+
+    // Copies use the heap
+    Url::CompactUrl copy(compact);
+    EXPECT_EQ(compact, copy);
+    copy.setPath("/copy");
+    EXPECT_EQ(54, arena.allocated());
+}
+
+TEST(CompactTest, ArenaConstructionAvoidsHeap)
+{
+    Url::Arena arena;
+    // Components too long for std::string's small-string optimization
+    std::string url("http://user@Some-Long-Hostname.com:8080/a/path/longer/than/sso"
+        ";params?query=value&other=value#fragment-too");
+    Url::Url parsed(url);
+
+    // Start the arena's first block
+    arena.allocate(1);
+
+    size_t before = allocations;
+    Url::CompactUrl compact(url, arena);
+    Url::CompactUrl from_url(parsed, arena);
+    EXPECT_EQ(before, allocations);
+    EXPECT_EQ(parsed.str(), compact.str());
+    EXPECT_EQ(compact, from_url);
+
+    // Without an arena, the buffer is the only allocation
+    before = allocations;
+    Url::CompactUrl heap(url);
+    EXPECT_EQ(before + 1, allocations);
+}
+
+TEST(CompactTest, ArenaAssignment)
+{
+    Url::Arena arena;
+    Url::Arena other;
+    Url::CompactUrl compact("http://foo.com/", arena);
+    Url::CompactUrl heap("http://bar.com/");
+
+    // Assignment keeps the target's arena
+    compact = heap;
+    EXPECT_EQ("http://bar.com/", compact.str());
+    EXPECT_EQ(30, arena.allocated());
+
+    heap = compact;
+    EXPECT_EQ("http://bar.com/", heap.str());
+    EXPECT_EQ(30, arena.allocated());
+
+    // Moves between different arenas copy
+    Url::CompactUrl elsewhere("http://baz.com/", other);
+    compact = std::move(elsewhere);
+    EXPECT_EQ("http://baz.com/", compact.str());
+    EXPECT_EQ("http://baz.com/", elsewhere.str());
+    EXPECT_EQ(45, arena.allocated());
+
+    // Moves within one arena do not
+    Url::CompactUrl same("http://qux.com/", arena);
+    compact = std::move(same);
+    EXPECT_EQ("http://qux.com/", compact.str());
+    EXPECT_EQ(60, arena.allocated());
+
+    // Moving construction takes the arena along
+    Url::CompactUrl moved(std::move(compact));
+    moved.setPath("/path");
+    EXPECT_EQ("http://qux.com/path", moved.str());
+    EXPECT_EQ(79, arena.allocated());
+}
@@ -0,0 +1,103 @@
+#include <gtest/gtest.h>
+
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+#include "deparam.h"
+#include "url.h"
+
+namespace
+{
+    bool contains(const Url::DeparamFilter& filter, const std::string& name)
+    {
+        return filter.contains(name.data(), name.size());
+    }
+}
+
+TEST(DeparamFilterTest, Contains)
+{
+    Url::DeparamFilter filter({ "utm_source", "fbclid", "x" });
+    EXPECT_EQ(3, filter.size());
+    EXPECT_TRUE(contains(filter, "utm_source"));
+    EXPECT_TRUE(contains(filter, "UTM_Source"));
+    EXPECT_TRUE(contains(filter, "fbclid"));
+    EXPECT_TRUE(contains(filter, "X"));
+    EXPECT_FALSE(contains(filter, "utm_sourc"));
+    EXPECT_FALSE(contains(filter, "utm_source_"));
+    EXPECT_FALSE(contains(filter, "y"));
+    EXPECT_FALSE(contains(filter, ""));
+}
+
+TEST(DeparamFilterTest, EmptyName)
+{
+    Url::DeparamFilter filter({ "" });
+    EXPECT_TRUE(contains(filter, ""));
+    EXPECT_FALSE(contains(filter, "a"));
+}
+
+TEST(DeparamFilterTest, Empty)
+{
+    Url::DeparamFilter filter((std::unordered_set<std::string>()));
+    EXPECT_EQ(0, filter.size());
+    EXPECT_FALSE(contains(filter, ""));
+    EXPECT_FALSE(contains(filter, "a"));
+}
+
+TEST(DeparamFilterTest, UppercaseNamesNeverMatch)
+{
+    Url::DeparamFilter filter({ "Foo", "bar" });
+    EXPECT_EQ(1, filter.size());
+    EXPECT_FALSE(contains(filter, "Foo"));
+    EXPECT_FALSE(contains(filter, "foo"));
+    EXPECT_TRUE(contains(filter, "BAR"));
+}
+
+TEST(DeparamFilterTest, NonAscii)
+{
+    Url::DeparamFilter filter({ "caf\xc3\xa9" });
+    EXPECT_TRUE(contains(filter, "CAF\xc3\xa9"));
+    EXPECT_FALSE(contains(filter, "CAF\xc3\x89"));
+}
+
+TEST(DeparamFilterTest, ManyNames)
+{
+    std::unordered_set<std::string> blacklist;
+    for (size_t index = 0; index < 400; ++index)
+    {
+        blacklist.insert("param_" + std::to_string(index));
+    }
+    Url::DeparamFilter filter(blacklist);
+    EXPECT_EQ(400, filter.size());
+    for (size_t index = 0; index < 800; ++index)
+    {
+        std::string name("PARAM_" + std::to_string(index));
+        EXPECT_EQ(index < 400, contains(filter, name)) << name;
+    }
+}
+
+TEST(DeparamFilterTest, MatchesBlacklist)
+{
+    std::unordered_set<std::string> blacklist = { "utm_source", "x", "" };
+    Url::DeparamFilter filter(blacklist);
+    std::vector<std::string> examples = {
+        "http://foo.com/",
+        "http://foo.com/?",
+        "http://foo.com/?utm_source=1",
+        "http://foo.com/?a=1&UTM_SOURCE=2&b",
+        "http://foo.com/?&a&&b&",
+        "http://foo.com/?=1&x&a=&&",
+        "http://foo.com/?x=1&x=2&a=1",
+        "http://foo.com/path;x=1;a=2?x=1&y=2",
+        "http://foo.com/path;a;;b;x?a=b=c&x=d=e"
+    };
+    for (auto it = examples.begin(); it != examples.end(); ++it)
+    {
+        Url::Url expected(*it);
+        Url::Url actual(*it);
+        expected.deparam(blacklist);
+        actual.deparam(filter);
+        EXPECT_EQ(expected, actual) << *it;
+        EXPECT_EQ(expected.str(), actual.str()) << *it;
+    }
+}
@@ -0,0 +1,59 @@
+#include <gtest/gtest.h>
+
+#include <cstring>
+#include <string>
+
+#include "hash.h"
+
+namespace
+{
+    uint64_t hash(const std::string& str, uint64_t seed = 0)
+    {
+        return Url::Hasher::hash(str.data(), str.size(), seed);
+    }
+}
+
+TEST(HashTest, KnownValues)
+{
+    EXPECT_EQ(0xEF46DB3751D8E999ULL, hash(""));
+    EXPECT_EQ(0xD24EC4F1A98C6E5BULL, hash("a"));
+    EXPECT_EQ(0x44BC2CF5AD770999ULL, hash("abc"));
+    EXPECT_EQ(0xFBCEA83C8A378BF1ULL, hash("Nobody inspects the spammish repetition"));
+}
+
+TEST(HashTest, Seed)
+{
+    EXPECT_NE(hash("abc"), hash("abc", 1));
+    EXPECT_EQ(hash("abc", 1), Url::Hasher(1).update("abc", 3).digest());
+}
+
+TEST(HashTest, Pieces)
+{
+    std::string str;
+    for (size_t index = 0; index < 100; ++index)
+    {
+        str.append(1, static_cast<char>('a' + (index * 7) % 26));
+    }
+
+    // Every way of splitting the input in three gives the same result
+    for (size_t first = 0; first <= str.size(); first += 3)
+    {
+        for (size_t second = first; second <= str.size(); second += 5)
+        {
+            Url::Hasher hasher;
+            hasher.update(str.data(), first);
+            hasher.update(str.data() + first, second - first);
+            hasher(str.data() + second, str.size() - second);
+            EXPECT_EQ(hash(str), hasher.digest()) << first << ", " << second;
+        }
+    }
+}
+
+TEST(HashTest, DigestDoesNotConsume)
+{
+    Url::Hasher hasher;
+    hasher.update("abc", 3);
+    EXPECT_EQ(hasher.digest(), hasher.digest());
+    hasher.update("def", 3);
+    EXPECT_EQ(hash("abcdef"), hasher.digest());
+}
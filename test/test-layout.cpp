@@ -0,0 +1,77 @@
+#include <gtest/gtest.h>
+
+#include <string>
+
+#include "layout.h"
+
+namespace
+{
+    std::string written(const Url::Layout& layout)
+    {
+        std::string result(layout.size(), '\0');
+        char* end = layout.write(&result[0]);
+        EXPECT_EQ(&result[0] + result.size(), end);
+        return result;
+    }
+}
+
+TEST(LayoutTest, Offsets)
+{
+    std::string url("http://user@foo.com:8080/path;params?query#fragment");
+    Url::UrlView view(url);
+    Url::Layout layout(view);
+    ASSERT_EQ(url, written(layout));
+    EXPECT_EQ(0u, layout.schemeOffset());
+    EXPECT_EQ(7u, layout.userinfoOffset());
+    EXPECT_EQ(12u, layout.hostOffset());
+    EXPECT_EQ(24u, layout.pathOffset());
+    EXPECT_EQ(30u, layout.paramsOffset());
+    EXPECT_EQ(37u, layout.queryOffset());
+    EXPECT_EQ(43u, layout.fragmentOffset());
+}
+
+TEST(LayoutTest, EmptyComponents)
+{
+    std::string url("http://foo.com");
+    Url::UrlView view(url);
+    Url::Layout layout(view);
+    EXPECT_EQ("http://foo.com/", written(layout));
+    EXPECT_EQ(7u, layout.userinfoOffset());
+    EXPECT_EQ(15u, layout.pathOffset());
+    EXPECT_EQ(15u, layout.paramsOffset());
+    EXPECT_EQ(15u, layout.queryOffset());
+    EXPECT_EQ(15u, layout.fragmentOffset());
+}
+
+TEST(LayoutTest, MatchesStr)
+{
+    std::vector<std::string> examples = {
+        "",
+        "path",
+        "/path",
+        "//foo.com",
+        "//foo.com/path",
+        "?query",
+        "#fragment",
+        ";params",
+        "mailto:user@example.com",
+        "custom:thing",
+        "file:///tmp/junk.txt",
+        "http://foo.com:8080",
+        "http://foo.com/;?#",
+        "HTTP://Foo.com/Path"
+    };
+    for (auto it = examples.begin(); it != examples.end(); ++it)
+    {
+        Url::UrlView view(*it);
+        EXPECT_EQ(Url::Url(view).str(), written(Url::Layout(Url::Url(view).view())))
+            << *it;
+    }
+}
+
+TEST(LayoutTest, PreservesCase)
+{
+    std::string url("HTTP://Foo.com/Path");
+    Url::UrlView view(url);
+    EXPECT_EQ("HTTP://Foo.com/Path", written(Url::Layout(view)));
+}
@@ -1,6 +1,12 @@
 #include <gtest/gtest.h>
 
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
 #include "punycode.h"
+#include "url.h"
 
 TEST(PunycoderTest, NeedsPunycoding)
 {
@@ -250,6 +256,14 @@ TEST(PunycoderTest, DecodeNonBase36Char)
     ASSERT_THROW(Url::Punycode::decode(example), std::invalid_argument);
 }
 
+TEST(PunycoderTest, DecodeHighByte)
+{
+    // Bytes above 0x7F are not base36 characters either
+    std::string output;
+    EXPECT_EQ(Url::Punycode::Status::INVALID_DIGIT,
+        Url::Punycode::decode(std::string("a\xe0"), output));
+}
+
 TEST(PunycoderTest, DecodeOverflowI)
 {
     // This was the (seemingly) smallest reproducing substring from a random string
@@ -268,3 +282,92 @@ TEST(PunycoderTest, DecodeOverflowN)
     }
     ASSERT_THROW(Url::Punycode::decode(example), std::invalid_argument);
 }
+
+TEST(PunycoderTest, DecodeCodepointTooHigh)
+{
+    // Decodes to a codepoint beyond the highest allowed by unicode
+    std::string example = "bb00z";
+    ASSERT_THROW(Url::Punycode::decode(example), std::invalid_argument);
+}
+
+TEST(PunycoderTest, EncodeStatus)
+{
+    std::string output;
+    EXPECT_EQ(Url::Punycode::Status::OK,
+        Url::Punycode::encode("b\xc3\xbc" "cher", output));
+    EXPECT_EQ("bcher-kva", output);
+
+    std::string invalid = { static_cast<char>(0x9D) };
+    EXPECT_EQ(Url::Punycode::Status::INVALID_UTF8,
+        Url::Punycode::encode(invalid, output));
+
+    std::string overflow(3855, 'a');
+    overflow.append("\xF4\x8F\xBF\xBF");
+    EXPECT_EQ(Url::Punycode::Status::OVERFLOW_DELTA_UPDATE,
+        Url::Punycode::encode(overflow, output));
+
+    std::string increment = std::string(8190, 'a') + "\xC2\x80\xF2\x80\x82\x80";
+    EXPECT_EQ(Url::Punycode::Status::OVERFLOW_DELTA_INCREMENT,
+        Url::Punycode::encode(increment, output));
+}
+
+TEST(PunycoderTest, DecodeStatus)
+{
+    std::string output;
+    EXPECT_EQ(Url::Punycode::Status::OK, Url::Punycode::decode("bcher-kva", output));
+    EXPECT_EQ("b\xc3\xbc" "cher", output);
+
+    EXPECT_EQ(Url::Punycode::Status::PREMATURE_TERMINATION,
+        Url::Punycode::decode("d9juau41awczcz", output));
+    EXPECT_EQ(Url::Punycode::Status::NON_BASIC_CODEPOINT,
+        Url::Punycode::decode("\xc3\xbc-", output));
+    EXPECT_EQ(Url::Punycode::Status::INVALID_DIGIT,
+        Url::Punycode::decode("/", output));
+    EXPECT_EQ(Url::Punycode::Status::OVERFLOW_I,
+        Url::Punycode::decode("s121kz41webp2qdk6492joxumu36", output));
+    EXPECT_EQ(Url::Punycode::Status::CODEPOINT_TOO_HIGH,
+        Url::Punycode::decode("bb00z", output));
+
+    std::string overflow("999999b");
+    for (unsigned int i = 0; i < 5; ++i)
+    {
+        overflow.append(overflow);
+    }
+    EXPECT_EQ(Url::Punycode::Status::OVERFLOW_N, Url::Punycode::decode(overflow, output));
+}
+
+TEST(PunycoderTest, InvalidUtf8Messages)
+{
+    // Throwing encodes report the specific UTF-8 error
+    std::vector<std::pair<std::string, std::string>> examples = {
+        { "\x80", "Low UTF-8 start byte" },
+        { "\xc3", "UTF-8 sequence terminated early." },
+        { "\xff", "High UTF-8 start byte" }
+    };
+    for (auto it = examples.begin(); it != examples.end(); ++it)
+    {
+        std::string str(it->first);
+        try
+        {
+            Url::Punycode::encode(str);
+            ADD_FAILURE() << "Expected std::invalid_argument";
+        }
+        catch (const std::invalid_argument& exc)
+        {
+            EXPECT_EQ(it->second, exc.what());
+        }
+    }
+
+    std::string str("\x80");
+    EXPECT_THROW(Url::Punycode::encode(str), std::invalid_argument);
+    EXPECT_THROW(Url::Url("http://\xc3/").punycode(), std::invalid_argument);
+}
+
+TEST(PunycoderTest, StatusMessages)
+{
+    EXPECT_STREQ("OK", Url::Punycode::message(Url::Punycode::Status::OK));
+    EXPECT_STREQ("Invalid UTF-8.",
+        Url::Punycode::message(Url::Punycode::Status::INVALID_UTF8));
+    EXPECT_STREQ("Overflow on w.",
+        Url::Punycode::message(Url::Punycode::Status::OVERFLOW_W));
+}
@@ -0,0 +1,105 @@
+#include <gtest/gtest.h>
+
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "query.h"
+#include "url.h"
+
+namespace
+{
+    typedef std::vector<std::pair<std::string, std::string>> pairs;
+
+    pairs collect(const Url::QueryView& view)
+    {
+        pairs result;
+        for (auto it = view.begin(); it != view.end(); ++it)
+        {
+            result.push_back(std::make_pair(it->key.str(), it->value.str()));
+        }
+        return result;
+    }
+}
+
+TEST(QueryViewTest, Pairs)
+{
+    Url::Url url("http://foo.com/path?a=1&b=&c&d=x=y");
+    pairs expected = {
+        {"a", "1"}, {"b", ""}, {"c", ""}, {"d", "x=y"}
+    };
+    EXPECT_EQ(expected, collect(Url::QueryView(url.query())));
+}
+
+TEST(QueryViewTest, Params)
+{
+    Url::Url url("http://foo.com/path;a=1;b=2?c=3");
+    pairs expected = { {"a", "1"}, {"b", "2"} };
+    EXPECT_EQ(expected, collect(Url::QueryView(url.params(), ';')));
+}
+
+TEST(QueryViewTest, EmptyPieces)
+{
+    pairs expected = { {"a", "1"}, {"", "2"}, {"b", ""} };
+    EXPECT_EQ(expected, collect(Url::QueryView("&&a=1&&=2&b&&")));
+    EXPECT_EQ(pairs(), collect(Url::QueryView("&&&")));
+    EXPECT_EQ(pairs(), collect(Url::QueryView("")));
+    EXPECT_EQ(pairs(), collect(Url::QueryView(Url::StringView())));
+}
+
+TEST(QueryViewTest, ReferencesInput)
+{
+    std::string query("key=value");
+    Url::QueryView view(query);
+    EXPECT_EQ(query.data(), view.begin()->key.data());
+    EXPECT_EQ(query.data() + 4, view.begin()->value.data());
+}
+
+TEST(QueryViewTest, PostIncrement)
+{
+    Url::QueryView view("a=1&b=2");
+    auto it = view.begin();
+    EXPECT_EQ("a", (it++)->key.str());
+    EXPECT_EQ("b", it->key.str());
+    EXPECT_TRUE(++it == view.end());
+}
+
+TEST(QueryViewTest, Count)
+{
+    EXPECT_EQ(0, Url::QueryView("").count());
+    EXPECT_EQ(1, Url::QueryView("a").count());
+    EXPECT_EQ(3, Url::QueryView("a&b=&&c=1&").count());
+}
+
+TEST(QueryViewTest, HasAndGet)
+{
+    Url::QueryView view("page=2&sid=abc&empty=&flag&page=3");
+    EXPECT_TRUE(view.has("page"));
+    EXPECT_EQ("2", view.get("page").str());
+    EXPECT_EQ("abc", view.get("sid").str());
+    EXPECT_TRUE(view.has("empty"));
+    EXPECT_EQ("", view.get("empty").str());
+    EXPECT_TRUE(view.has("flag"));
+    EXPECT_FALSE(view.has("missing"));
+    EXPECT_FALSE(view.has("PAGE"));
+    EXPECT_FALSE(view.has("pag"));
+    EXPECT_TRUE(view.get("missing").empty());
+}
+
+TEST(QueryViewTest, Decoded)
+{
+    Url::QueryView view("a%20b=c%26d%2");
+    std::string key("key:");
+    std::string value("value:");
+    view.begin()->decodedKey(key);
+    view.begin()->decodedValue(value);
+    EXPECT_EQ("key:a b", key);
+    EXPECT_EQ("value:c&d%2", value);
+}
+
+TEST(QueryViewTest, Unescaped)
+{
+    std::string out("prefix:");
+    Url::Url::unescaped("%41%42c%", out);
+    EXPECT_EQ("prefix:ABc%", out);
+}
@@ -0,0 +1,180 @@
+#include <gtest/gtest.h>
+
+#include <random>
+#include <string>
+#include <vector>
+
+#include "scan.h"
+
+namespace
+{
+    // All the positions of delimiters in str, found one character at a time.
+    std::vector<size_t> naive(const std::string& str)
+    {
+        std::vector<size_t> positions;
+        for (size_t index = 0; index < str.size(); ++index)
+        {
+            if (Url::Scan::isDelimiter(str[index]))
+            {
+                positions.push_back(index);
+            }
+        }
+        return positions;
+    }
+
+    // All the positions of delimiters in str, found with Delimiters.
+    std::vector<size_t> scanned(const std::string& str)
+    {
+        std::vector<size_t> positions;
+        const char* end = str.data() + str.size();
+        Url::Scan::Delimiters delimiters(str.data(), end);
+        for (const char* it = delimiters.next(); it != end; it = delimiters.next())
+        {
+            positions.push_back(it - str.data());
+        }
+        return positions;
+    }
+
+    std::string randomString(std::mt19937& generator, size_t length)
+    {
+        std::string result;
+        for (size_t index = 0; index < length; ++index)
+        {
+            result.append(1, static_cast<char>(generator() & 0xFF));
+        }
+        return result;
+    }
+}
+
+TEST(ScanTest, Delimiters)
+{
+    for (char c = 1; c != 0; ++c)
+    {
+        bool expected = std::string(":/?#@;[]").find(c) != std::string::npos;
+        EXPECT_EQ(expected, Url::Scan::isDelimiter(c));
+    }
+    EXPECT_FALSE(Url::Scan::isDelimiter('\0'));
+}
+
+TEST(ScanTest, ScalarMask)
+{
+    std::string block("http://foo.com/p;q?r#s[@]");
+    EXPECT_EQ(0x1u, Url::Scan::delimitersScalar(":abc", 4));
+    EXPECT_EQ(0x0u, Url::Scan::delimitersScalar("abcdefgh", 8));
+    EXPECT_EQ(0x0u, Url::Scan::delimitersScalar(":", 0));
+    EXPECT_EQ(0x154070u, Url::Scan::delimitersScalar(block.data(), 21));
+}
+
+TEST(ScanTest, BlockMatchesScalar)
+{
+    std::mt19937 generator(42);
+    for (size_t trial = 0; trial < 10000; ++trial)
+    {
+        std::string block = randomString(generator, Url::Scan::BLOCK_SIZE);
+        EXPECT_EQ(
+            Url::Scan::delimitersScalar(block.data(), block.size()),
+            Url::Scan::delimiters(block.data()));
+    }
+}
+
+TEST(ScanTest, Url)
+{
+    std::string url("http://user@foo.com:8080/path;params?query#fragment");
+    std::vector<size_t> expected = { 4, 5, 6, 11, 19, 24, 29, 36, 42 };
+    EXPECT_EQ(expected, scanned(url));
+}
+
+TEST(ScanTest, Empty)
+{
+    EXPECT_EQ(std::vector<size_t>(), scanned(""));
+}
+
+TEST(ScanTest, NoDelimiters)
+{
+    std::string str(100, 'a');
+    EXPECT_EQ(std::vector<size_t>(), scanned(str));
+}
+
+TEST(ScanTest, AllDelimiters)
+{
+    std::string str(100, '/');
+    EXPECT_EQ(naive(str), scanned(str));
+}
+
+TEST(ScanTest, ExhaustedRepeatedly)
+{
+    std::string str("a/b");
+    const char* end = str.data() + str.size();
+    Url::Scan::Delimiters delimiters(str.data(), end);
+    EXPECT_EQ(str.data() + 1, delimiters.next());
+    EXPECT_EQ(end, delimiters.next());
+    EXPECT_EQ(end, delimiters.next());
+}
+
+TEST(ScanTest, MatchesNaive)
+{
+    std::mt19937 generator(7);
+    for (size_t length = 0; length < 200; ++length)
+    {
+        std::string str = randomString(generator, length);
+        EXPECT_EQ(naive(str), scanned(str));
+    }
+}
+
+TEST(ScanTest, PlainMatchesScalar)
+{
+    std::mt19937 generator(42);
+    const Url::CharacterClass* classes[] = { &Url::Url::PATH, &Url::Url::QUERY };
+    for (size_t length = 0; length < 100; ++length)
+    {
+        for (size_t trial = 0; trial < 20; ++trial)
+        {
+            // Mostly plain bytes, with the occasional byte that is not
+            std::string str(length, 'a');
+            for (size_t index = 0; index < length; ++index)
+            {
+                if (generator() % 8 == 0)
+                {
+                    str[index] = static_cast<char>(generator() & 0xFF);
+                }
+            }
+
+            for (size_t index = 0; index < 2; ++index)
+            {
+                const Url::CharacterClass& safe = *classes[index];
+                EXPECT_EQ(Url::Scan::plainScalar(str.data(), str.size(), safe),
+                          Url::Scan::plain(str.data(), str.size(), safe)) << str;
+            }
+        }
+    }
+}
+
+TEST(ScanTest, Plain)
+{
+    std::string str("/some/long/path/with/no/special/characters/in/it%20then");
+    EXPECT_EQ(str.find('%'), Url::Scan::plain(str.data(), str.size(), Url::Url::PATH));
+    str.append(" \xff");
+    EXPECT_EQ(str.find('%'), Url::Scan::plain(str.data(), str.size(), Url::Url::PATH));
+    EXPECT_EQ(3, Url::Scan::plain("a/b?", 4, Url::Url::PATH));
+    EXPECT_EQ(4, Url::Scan::plain("a/b?", 4, Url::Url::QUERY));
+    EXPECT_EQ(0, Url::Scan::plain("", 0, Url::Url::QUERY));
+}
+
+TEST(ScanTest, PlainNonAscii)
+{
+    // Sets with non-ASCII members are classified one byte at a time
+    static const Url::CharacterClass high("abc\xe0");
+    std::string str(40, 'a');
+    str.append("\xe0\xe1");
+    EXPECT_EQ(41, Url::Scan::plain(str.data(), str.size(), high));
+}
+
+TEST(ScanTest, Nibbles)
+{
+    static const Url::CharacterClass set("Aa%\xc1");
+    EXPECT_FALSE(set.ascii());
+    EXPECT_TRUE(Url::Url::PATH.ascii());
+    EXPECT_EQ((1 << 4) | (1 << 6), set.nibbles()[1]);
+    EXPECT_EQ(1 << 2, set.nibbles()[5]);
+    EXPECT_EQ(0, set.nibbles()[2]);
+}
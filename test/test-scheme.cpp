@@ -0,0 +1,74 @@
+#include <gtest/gtest.h>
+
+#include <cstring>
+#include <string>
+
+#include "scheme.h"
+#include "url.h"
+
+namespace
+{
+    const Url::Scheme FIRST = Url::Scheme::NONE;
+    const Url::Scheme LAST = Url::Scheme::UNKNOWN;
+
+    Url::Scheme next(Url::Scheme scheme)
+    {
+        return static_cast<Url::Scheme>(static_cast<uint8_t>(scheme) + 1);
+    }
+
+    bool contains(const std::unordered_set<std::string>& schemes, const char* name)
+    {
+        return schemes.find(name) != schemes.end();
+    }
+}
+
+TEST(SchemeTest, RoundTrip)
+{
+    for (Url::Scheme scheme = FIRST; scheme != LAST; scheme = next(scheme))
+    {
+        const char* name = Url::Schemes::name(scheme);
+        EXPECT_EQ(scheme, Url::Schemes::classify(name, std::strlen(name))) << name;
+    }
+}
+
+TEST(SchemeTest, MatchesSets)
+{
+    for (Url::Scheme scheme = FIRST; scheme != LAST; scheme = next(scheme))
+    {
+        const char* name = Url::Schemes::name(scheme);
+        uint8_t flags = Url::Schemes::flags(scheme);
+        EXPECT_EQ(contains(Url::Url::USES_RELATIVE, name),
+            bool(flags & Url::Schemes::USES_RELATIVE)) << name;
+        EXPECT_EQ(contains(Url::Url::USES_NETLOC, name),
+            bool(flags & Url::Schemes::USES_NETLOC)) << name;
+        EXPECT_EQ(contains(Url::Url::USES_PARAMS, name),
+            bool(flags & Url::Schemes::USES_PARAMS)) << name;
+        EXPECT_TRUE(flags & Url::Schemes::KNOWN) << name;
+
+        auto port = Url::Url::PORTS.find(name);
+        EXPECT_EQ(port == Url::Url::PORTS.end() ? 0 : port->second,
+            Url::Schemes::defaultPort(scheme)) << name;
+    }
+    EXPECT_EQ(Url::Url::KNOWN_PROTOCOLS.size(), static_cast<size_t>(LAST));
+}
+
+TEST(SchemeTest, Unknown)
+{
+    EXPECT_EQ(Url::Scheme::UNKNOWN, Url::Schemes::classify("htt", 3));
+    EXPECT_EQ(Url::Scheme::UNKNOWN, Url::Schemes::classify("httpss", 6));
+    EXPECT_EQ(Url::Scheme::UNKNOWN, Url::Schemes::classify("prosperos", 9));
+    EXPECT_EQ(Url::Scheme::UNKNOWN, Url::Schemes::classify("http\0", 5));
+    EXPECT_EQ(0, Url::Schemes::flags(Url::Scheme::UNKNOWN));
+    EXPECT_EQ(0, Url::Schemes::defaultPort(Url::Scheme::UNKNOWN));
+    EXPECT_STREQ("", Url::Schemes::name(Url::Scheme::UNKNOWN));
+}
+
+TEST(SchemeTest, Case)
+{
+    EXPECT_EQ(Url::Scheme::UNKNOWN, Url::Schemes::classify("HTTP", 4));
+    EXPECT_EQ(Url::Scheme::HTTP, Url::Schemes::classifyInsensitive("HTTP", 4));
+    EXPECT_EQ(Url::Scheme::SVN_SSH, Url::Schemes::classifyInsensitive("SvN+sSh", 7));
+    EXPECT_EQ(Url::Scheme::PROSPERO, Url::Schemes::classifyInsensitive("PROSPERO", 8));
+    EXPECT_EQ(Url::Scheme::UNKNOWN, Url::Schemes::classifyInsensitive("PROSPEROS", 9));
+    EXPECT_EQ(Url::Scheme::NONE, Url::Schemes::classifyInsensitive("", 0));
+}
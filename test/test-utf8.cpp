@@ -98,3 +98,41 @@ TEST(Utf8Test, Japanese)
     EXPECT_EQ(codepoints, Url::Utf8::toCodepoints(str));
     EXPECT_EQ(str, Url::Utf8::fromCodepoints(codepoints));
 }
+
+TEST(Utf8Test, ReadStatus)
+{
+    std::string str = "\xC3\xBC" "a";
+    auto it = str.cbegin();
+    Url::Utf8::codepoint_t value = 0;
+    EXPECT_EQ(Url::Utf8::Status::OK, Url::Utf8::readCodepoint(it, str.cend(), value));
+    EXPECT_EQ(252u, value);
+    EXPECT_EQ(Url::Utf8::Status::OK, Url::Utf8::readCodepoint(it, str.cend(), value));
+    EXPECT_EQ(97u, value);
+    EXPECT_EQ(str.cend(), it);
+}
+
+TEST(Utf8Test, ReadStatusInvalid)
+{
+    Url::Utf8::codepoint_t value = 0;
+    std::vector<std::pair<std::string, Url::Utf8::Status>> examples = {
+        { { static_cast<char>(0x9D) }, Url::Utf8::Status::LOW_START_BYTE },
+        { { static_cast<char>(0xF9) }, Url::Utf8::Status::HIGH_START_BYTE },
+        { { static_cast<char>(0xF0), static_cast<char>(0x8A) },
+            Url::Utf8::Status::TERMINATED_EARLY },
+        { { static_cast<char>(0xF0), static_cast<char>(0xC0) },
+            Url::Utf8::Status::INVALID_CONTINUATION }
+    };
+    for (auto example = examples.begin(); example != examples.end(); ++example)
+    {
+        auto it = example->first.cbegin();
+        EXPECT_EQ(example->second,
+            Url::Utf8::readCodepoint(it, example->first.cend(), value));
+    }
+}
+
+TEST(Utf8Test, StatusMessages)
+{
+    EXPECT_STREQ("OK", Url::Utf8::message(Url::Utf8::Status::OK));
+    EXPECT_STREQ("Code point too high.",
+        Url::Utf8::message(Url::Utf8::Status::CODEPOINT_TOO_HIGH));
+}